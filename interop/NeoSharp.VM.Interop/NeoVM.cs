@@ -40,6 +40,11 @@ namespace NeoSharp.VM.Interop
         /// </summary>
         public static bool IsLoaded { get; private set; }
 
+        /// <summary>
+        /// Native engines kept by each thread for reuse, zero disables the pool
+        /// </summary>
+        public static int EnginePoolSize { get; set; } = 4;
+
         #endregion
 
         #region Core cache
@@ -83,6 +88,7 @@ namespace NeoSharp.VM.Interop
         internal delegate byte delByte_HandleRefInt(IntPtr item, out int size);
         internal delegate IntPtr delHandle_HandleInt(IntPtr pointer, int value);
         internal delegate byte delByte_HandleUInt64(IntPtr pointer, ulong value);
+        internal delegate void delVoid_HandleUInt64(IntPtr pointer, ulong value);
         internal delegate void delVoid_HandleHandle(IntPtr pointer1, IntPtr pointer2);
         internal delegate byte delByte_HandleHandle(IntPtr pointer1, IntPtr pointer2);
         internal delegate IntPtr delHandle_HandleHandle(IntPtr pointer1, IntPtr pointer2);
@@ -93,6 +99,7 @@ namespace NeoSharp.VM.Interop
         internal delegate void delVoid_HandleHandleInt(IntPtr pointer1, IntPtr pointer2, int value);
         internal delegate int delInt_HandleHandleIntInt(IntPtr pointer1, IntPtr pointer2, int value, int value2);
         internal delegate void delVoid_HandleHandleHandle(IntPtr pointer1, IntPtr pointer2, IntPtr pointer3);
+        internal delegate void delVoid_HandleHandleIntHandle(IntPtr pointer1, IntPtr pointer2, int value, IntPtr pointer3);
 
         // Specific
 
@@ -103,6 +110,25 @@ namespace NeoSharp.VM.Interop
             out IntPtr invocationHandle, out IntPtr resultStack
             );
 
+        internal delegate IntPtr delForkExecutionEngine
+            (
+            IntPtr handle,
+            InvokeInteropCallback interopCallback, LoadScriptCallback scriptCallback, GetMessageCallback getMessageCallback,
+            out IntPtr invocationHandle, out IntPtr resultStack
+            );
+
+        internal delegate byte delResetExecutionEngine
+            (
+            IntPtr handle,
+            InvokeInteropCallback interopCallback, LoadScriptCallback scriptCallback, GetMessageCallback getMessageCallback
+            );
+
+        internal delegate void delSetCallbacksExecutionEngine
+            (
+            IntPtr handle,
+            InvokeInteropCallback interopCallback, LoadScriptCallback scriptCallback, GetMessageCallback getMessageCallback
+            );
+
         internal delegate void delExecutionContextClaim
             (
             IntPtr handle, out IntPtr invocationHandle, out IntPtr resultStack
@@ -118,6 +144,9 @@ namespace NeoSharp.VM.Interop
 
         internal static delCreateExecutionEngine ExecutionEngine_Create;
         internal static delVoid_RefHandle ExecutionEngine_Free;
+        internal static delResetExecutionEngine ExecutionEngine_Reset;
+        internal static delSetCallbacksExecutionEngine ExecutionEngine_SetCallbacks;
+        internal static delForkExecutionEngine ExecutionEngine_Fork;
         internal static delInt_HandleHandleIntInt ExecutionEngine_LoadScript;
         internal static delByte_HandleIntInt ExecutionEngine_LoadCachedScript;
         internal static delByte_HandleUInt64 ExecutionEngine_Execute;
@@ -126,6 +155,11 @@ namespace NeoSharp.VM.Interop
         internal static delVoid_Handle ExecutionEngine_StepOut;
         internal static delByte_Handle ExecutionEngine_GetState;
         internal static delUInt64_Handle ExecutionEngine_GetConsumedGas;
+        internal static delUInt64_Handle ExecutionEngine_GetMemoryUsage;
+        internal static delUInt64_Handle ExecutionEngine_GetPeakMemoryUsage;
+        internal static delVoid_HandleUInt64 ExecutionEngine_SetMemoryLimit;
+        internal static delVoid_HandleInt ExecutionEngine_SetVerificationThreads;
+        internal static delVoid_HandleHandleIntHandle ExecutionEngine_SetMessage;
         internal static delVoid_HandleUInt ExecutionEngine_Clean;
         internal static delByte_HandleUInt64 ExecutionEngine_IncreaseGas;
         internal static delVoid_HandleOnStepIntoCallback ExecutionEngine_AddLog;
@@ -166,6 +200,7 @@ namespace NeoSharp.VM.Interop
         internal static delByte_Handle ExecutionContext_GetNextInstruction;
         internal static delInt_Handle ExecutionContext_GetInstructionPointer;
         internal static delExecutionContextClaim ExecutionContext_Claim;
+        internal static delVoid_Handle ExecutionContext_UnClaim;
 
 #pragma warning restore CS0649
 
@@ -173,6 +208,14 @@ namespace NeoSharp.VM.Interop
 
         #endregion
 
+        /// <summary>
+        /// Free the native engines pooled by the current thread, a thread that won't create engines again should call it before exiting
+        /// </summary>
+        public static void ClearEnginePool()
+        {
+            ExecutionEnginePool.Clear();
+        }
+
         /// <summary>
         /// Try Load library
         /// </summary>
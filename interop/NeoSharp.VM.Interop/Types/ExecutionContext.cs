@@ -26,6 +26,11 @@ namespace NeoSharp.VM.Interop.Types
         /// </summary>
         private readonly ExecutionEngine _engine;
 
+        /// <summary>
+        /// The claim of the native context was released
+        /// </summary>
+        private bool _released;
+
         #endregion
 
         #region Public fields
@@ -117,10 +122,38 @@ namespace NeoSharp.VM.Interop.Types
 
             _handle = handle;
 
+            // The native context is not reused after it returns, until this wrapper is released
+
             NeoVM.ExecutionContext_Claim(_handle, out IntPtr evHandle, out IntPtr altHandle);
 
             _altStack = new StackItemStack(engine, altHandle);
             _evaluationStack = new StackItemStack(engine, evHandle);
         }
+
+        /// <summary>
+        /// Release the native context, the engine can reuse it after the next Clean
+        /// </summary>
+        internal void Release()
+        {
+            if (_released) return;
+
+            _released = true;
+            GC.SuppressFinalize(this);
+
+            if (!_engine.IsDisposed)
+            {
+                NeoVM.ExecutionContext_UnClaim(_handle);
+            }
+        }
+
+        /// <summary>
+        /// Destructor
+        /// </summary>
+        ~ExecutionContext()
+        {
+            // The finalizer thread can't touch the native engine, it's released by the next Clean
+
+            _engine.ReleaseContext(_handle);
+        }
     }
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
-using System;
+﻿using System;
+using System.Collections.Concurrent;
 using System.Collections.Generic;
 using System.Numerics;
 using System.Runtime.InteropServices;
@@ -25,6 +26,11 @@ namespace NeoSharp.VM.Interop.Types
         /// </summary>
         private IntPtr _handle;
 
+        /// <summary>
+        /// Native handles of the stacks
+        /// </summary>
+        private readonly IntPtr _invocationHandle, _resultHandle;
+
         /// <summary>
         /// Last message
         /// </summary>
@@ -46,10 +52,25 @@ namespace NeoSharp.VM.Interop.Types
         private readonly List<InteropCacheEntry> _interopCache;
         private readonly List<object> _interopCacheIndex;
 
+        /// <summary>
+        /// Native contexts of the finalized ExecutionContexts, released by the next Clean
+        /// </summary>
+        private readonly ConcurrentQueue<IntPtr> _releasedContexts = new ConcurrentQueue<IntPtr>();
+
+        /// <summary>
+        /// Engines that hold each disposable interop object, shared with the forks. The last one disposes it
+        /// </summary>
+        private readonly Dictionary<IDisposable, int> _interopReferences;
+
         #endregion
 
         #region Public fields
 
+        /// <summary>
+        /// State after exceeding the memory limit, FAULT_BY_MEMORY of the native EVMState (EVMState has no value for it)
+        /// </summary>
+        public const EVMState FaultByMemory = (EVMState)4;
+
         /// <summary>
         /// Native handle
         /// </summary>
@@ -80,6 +101,16 @@ namespace NeoSharp.VM.Interop.Types
         /// </summary>
         public override ulong ConsumedGas => NeoVM.ExecutionEngine_GetConsumedGas(_handle);
 
+        /// <summary>
+        /// Bytes held by the live stack items
+        /// </summary>
+        public ulong MemoryUsage => NeoVM.ExecutionEngine_GetMemoryUsage(_handle);
+
+        /// <summary>
+        /// Max bytes held by the live stack items since the last Clean
+        /// </summary>
+        public ulong PeakMemoryUsage => NeoVM.ExecutionEngine_GetPeakMemoryUsage(_handle);
+
         #endregion
 
         /// <summary>
@@ -90,21 +121,80 @@ namespace NeoSharp.VM.Interop.Types
         {
             _interopCache = new List<InteropCacheEntry>();
             _interopCacheIndex = new List<object>();
+            _interopReferences = new Dictionary<IDisposable, int>();
 
             _internalInvokeInterop = new NeoVM.InvokeInteropCallback(InternalInvokeInterop);
             _internalLoadScript = new NeoVM.LoadScriptCallback(InternalLoadScript);
             _internalGetMessage = new NeoVM.GetMessageCallback(InternalGetMessage);
 
-            _handle = NeoVM.ExecutionEngine_Create
+            // Reuse a released engine of this thread when possible
+
+            if (!ExecutionEnginePool.TryTake
                 (
                 _internalInvokeInterop, _internalLoadScript, _internalGetMessage,
-                out IntPtr invHandle, out IntPtr resHandle
+                out _handle, out _invocationHandle, out _resultHandle
+                ))
+            {
+                _handle = NeoVM.ExecutionEngine_Create
+                    (
+                    _internalInvokeInterop, _internalLoadScript, _internalGetMessage,
+                    out _invocationHandle, out _resultHandle
+                    );
+            }
+
+            if (_handle == IntPtr.Zero) throw new ExternalException();
+
+            _invocationStack = new ExecutionContextStack(this, _invocationHandle);
+            _resultStack = new StackItemStack(this, _resultHandle);
+
+            if (Logger != null)
+            {
+                if (Logger.Verbosity.HasFlag(ELogVerbosity.StepInto))
+                {
+                    _internalOnStepInto = new NeoVM.OnStepIntoCallback(InternalOnStepInto);
+                    NeoVM.ExecutionEngine_AddLog(_handle, _internalOnStepInto);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Fork constructor
+        /// </summary>
+        /// <param name="parent">Forked engine</param>
+        private ExecutionEngine(ExecutionEngine parent) : base(new ExecutionEngineArgs()
+        {
+            InteropService = parent.InteropService,
+            ScriptTable = parent.ScriptTable,
+            MessageProvider = parent.MessageProvider,
+            Logger = parent.Logger
+        })
+        {
+            // The native interop items keep their keys, so the cache starts as a copy
+
+            _interopCache = new List<InteropCacheEntry>(parent._interopCache);
+            _interopCacheIndex = new List<object>(parent._interopCacheIndex);
+            _interopReferences = parent._interopReferences;
+
+            foreach (var obj in _interopCacheIndex)
+            {
+                if (obj is IDisposable dsp) AddInteropReference(dsp);
+            }
+
+            _internalInvokeInterop = new NeoVM.InvokeInteropCallback(InternalInvokeInterop);
+            _internalLoadScript = new NeoVM.LoadScriptCallback(InternalLoadScript);
+            _internalGetMessage = new NeoVM.GetMessageCallback(InternalGetMessage);
+
+            _handle = NeoVM.ExecutionEngine_Fork
+                (
+                parent._handle,
+                _internalInvokeInterop, _internalLoadScript, _internalGetMessage,
+                out _invocationHandle, out _resultHandle
                 );
 
             if (_handle == IntPtr.Zero) throw new ExternalException();
 
-            _invocationStack = new ExecutionContextStack(this, invHandle);
-            _resultStack = new StackItemStack(this, resHandle);
+            _invocationStack = new ExecutionContextStack(this, _invocationHandle);
+            _resultStack = new StackItemStack(this, _resultHandle);
 
             if (Logger != null)
             {
@@ -116,6 +206,15 @@ namespace NeoSharp.VM.Interop.Types
             }
         }
 
+        /// <summary>
+        /// Create an independent engine with a copy of the stacks, the gas and the state of this one
+        /// </summary>
+        /// <returns>Forked engine</returns>
+        public ExecutionEngine Fork()
+        {
+            return new ExecutionEngine(this);
+        }
+
         /// <summary>
         /// Get interop object
         /// </summary>
@@ -132,7 +231,23 @@ namespace NeoSharp.VM.Interop.Types
         /// <param name="it">Context</param>
         void InternalOnStepInto(IntPtr it)
         {
-            Logger.RaiseOnStepInto(new ExecutionContext(this, it));
+            // The context is valid during the event, then it's released
+
+            var context = new ExecutionContext(this, it);
+
+            Logger.RaiseOnStepInto(context);
+            context.Release();
+        }
+
+        /// <summary>
+        /// Release a native context from the finalizer of its ExecutionContext
+        /// </summary>
+        /// <param name="handle">Context handle</param>
+        internal void ReleaseContext(IntPtr handle)
+        {
+            if (IsDisposed) return;
+
+            _releasedContexts.Enqueue(handle);
         }
 
         /// <summary>
@@ -265,12 +380,54 @@ namespace NeoSharp.VM.Interop.Types
             return NeoVM.ExecutionEngine_IncreaseGas(_handle, gas) == 0x01;
         }
 
+        /// <summary>
+        /// Set the max bytes that the stack items can hold, the execution faults when it's exceeded
+        /// </summary>
+        /// <param name="limit">Limit</param>
+        public void SetMemoryLimit(ulong limit)
+        {
+            NeoVM.ExecutionEngine_SetMemoryLimit(_handle, limit);
+        }
+
+        /// <summary>
+        /// Set the threads that verify the signatures of CHECKMULTISIG, 1 verifies them on the calling thread
+        /// </summary>
+        /// <param name="threads">Threads</param>
+        public void SetVerificationThreads(int threads)
+        {
+            NeoVM.ExecutionEngine_SetVerificationThreads(_handle, threads);
+        }
+
+        /// <summary>
+        /// Set the message of the current iteration (after Clean), so the signature checks don't ask the MessageProvider
+        /// </summary>
+        /// <param name="message">Message</param>
+        /// <param name="hash">SHA256 of the message, computed by the engine when it's null</param>
+        public void SetMessage(byte[] message, byte[] hash = null)
+        {
+            if (message == null) throw new ArgumentNullException(nameof(message));
+            if (hash != null && hash.Length != 32) throw new ArgumentException(nameof(hash));
+
+            fixed (byte* pMessage = message)
+            fixed (byte* pHash = hash)
+            {
+                NeoVM.ExecutionEngine_SetMessage(_handle, (IntPtr)pMessage, message.Length, (IntPtr)pHash);
+            }
+        }
+
         /// <summary>
         /// Clean Execution engine state
         /// </summary>
         /// <param name="iteration">Iteration</param>
         public override void Clean(uint iteration = 0)
         {
+            // The released contexts are reused from now on
+
+            while (!IsDisposed && _releasedContexts.TryDequeue(out var context))
+            {
+                NeoVM.ExecutionContext_UnClaim(context);
+            }
+
             NeoVM.ExecutionEngine_Clean(_handle, iteration);
         }
 
@@ -372,11 +529,48 @@ namespace NeoSharp.VM.Interop.Types
                 });
 
                 _interopCacheIndex.Add(obj);
+
+                if (obj is IDisposable dsp) AddInteropReference(dsp);
             }
 
             return new InteropStackItem<T>(this, obj, objKey);
         }
 
+        /// <summary>
+        /// Add a holder of the interop object
+        /// </summary>
+        /// <param name="obj">Object</param>
+        private void AddInteropReference(IDisposable obj)
+        {
+            lock (_interopReferences)
+            {
+                _interopReferences.TryGetValue(obj, out var count);
+                _interopReferences[obj] = count + 1;
+            }
+        }
+
+        /// <summary>
+        /// Remove a holder of the interop object
+        /// </summary>
+        /// <param name="obj">Object</param>
+        /// <returns>Return true if it was the last one, then the object must be disposed</returns>
+        private bool RemoveInteropReference(IDisposable obj)
+        {
+            lock (_interopReferences)
+            {
+                if (!_interopReferences.TryGetValue(obj, out var count)) return false;
+
+                if (count > 1)
+                {
+                    _interopReferences[obj] = count - 1;
+                    return false;
+                }
+
+                _interopReferences.Remove(obj);
+                return true;
+            }
+        }
+
         /// <summary>
         /// Create BooleanStackItem
         /// </summary>
@@ -434,9 +628,9 @@ namespace NeoSharp.VM.Interop.Types
             {
                 // Clear interop cache
 
-                foreach (var v in _interopCacheIndex)
+                foreach (var obj in _interopCacheIndex)
                 {
-                    if (v is IDisposable dsp)
+                    if (obj is IDisposable dsp && RemoveInteropReference(dsp))
                     {
                         dsp.Dispose();
                     }
@@ -444,6 +638,14 @@ namespace NeoSharp.VM.Interop.Types
 
                 _interopCache.Clear();
                 _interopCacheIndex.Clear();
+
+                // The pool is thread static, so the finalizer can't use it
+
+                if (ExecutionEnginePool.TryReturn(_handle, _invocationHandle, _resultHandle))
+                {
+                    _handle = IntPtr.Zero;
+                    return;
+                }
             }
 
             // free unmanaged resources (unmanaged objects) and override a finalizer below. set large fields to null.
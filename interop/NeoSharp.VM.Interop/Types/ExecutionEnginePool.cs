@@ -0,0 +1,143 @@
+﻿using System;
+using System.Collections.Generic;
+
+namespace NeoSharp.VM.Interop.Types
+{
+    /// <summary>
+    /// Native engines of the disposed ExecutionEngines, reset and reused by the next ones created in the same thread
+    /// </summary>
+    internal sealed class ExecutionEnginePool : IDisposable
+    {
+        private struct Entry
+        {
+            public IntPtr Handle;
+            public IntPtr InvocationHandle;
+            public IntPtr ResultHandle;
+        }
+
+        /// <summary>
+        /// Pool of the current thread, finalized (and its engines freed) once the thread is gone
+        /// </summary>
+        [ThreadStatic]
+        private static ExecutionEnginePool _current;
+
+        private readonly Stack<Entry> _entries = new Stack<Entry>();
+
+        /// <summary>
+        /// Take a pooled engine
+        /// </summary>
+        /// <param name="interopCallback">Interop callback</param>
+        /// <param name="scriptCallback">Load script callback</param>
+        /// <param name="getMessageCallback">Get message callback</param>
+        /// <param name="handle">Engine handle</param>
+        /// <param name="invHandle">Invocation stack handle</param>
+        /// <param name="resHandle">Result stack handle</param>
+        /// <returns>Return false if the pool is empty</returns>
+        public static bool TryTake
+            (
+            NeoVM.InvokeInteropCallback interopCallback, NeoVM.LoadScriptCallback scriptCallback, NeoVM.GetMessageCallback getMessageCallback,
+            out IntPtr handle, out IntPtr invHandle, out IntPtr resHandle
+            )
+        {
+            var pool = _current;
+
+            if (pool == null || pool._entries.Count == 0)
+            {
+                handle = invHandle = resHandle = IntPtr.Zero;
+                return false;
+            }
+
+            // The engine was reset when returned, only the callbacks of the new owner are missing
+
+            var entry = pool._entries.Pop();
+            NeoVM.ExecutionEngine_SetCallbacks(entry.Handle, interopCallback, scriptCallback, getMessageCallback);
+
+            handle = entry.Handle;
+            invHandle = entry.InvocationHandle;
+            resHandle = entry.ResultHandle;
+            return true;
+        }
+
+        /// <summary>
+        /// Return an engine to the pool
+        /// </summary>
+        /// <param name="handle">Engine handle</param>
+        /// <param name="invHandle">Invocation stack handle</param>
+        /// <param name="resHandle">Result stack handle</param>
+        /// <returns>Return false if the pool is full, then the engine must be freed</returns>
+        public static bool TryReturn(IntPtr handle, IntPtr invHandle, IntPtr resHandle)
+        {
+            var pool = _current;
+
+            if (pool == null)
+            {
+                if (NeoVM.EnginePoolSize <= 0) return false;
+
+                pool = _current = new ExecutionEnginePool();
+            }
+
+            if (pool._entries.Count >= NeoVM.EnginePoolSize)
+            {
+                return false;
+            }
+
+            // Release the items and the callbacks of the previous owner
+
+            if (NeoVM.ExecutionEngine_Reset(handle, null, null, null) != NeoVM.TRUE)
+            {
+                return false;
+            }
+
+            pool._entries.Push(new Entry()
+            {
+                Handle = handle,
+                InvocationHandle = invHandle,
+                ResultHandle = resHandle
+            });
+
+            return true;
+        }
+
+        /// <summary>
+        /// Free the engines pooled by the current thread
+        /// </summary>
+        public static void Clear()
+        {
+            var pool = _current;
+
+            if (pool == null) return;
+
+            _current = null;
+            pool.Dispose();
+        }
+
+        /// <summary>
+        /// Free the pooled engines
+        /// </summary>
+        private void Free()
+        {
+            while (_entries.Count > 0)
+            {
+                var entry = _entries.Pop();
+                NeoVM.ExecutionEngine_Free(ref entry.Handle);
+            }
+        }
+
+        /// <summary>
+        /// Dispose
+        /// </summary>
+        public void Dispose()
+        {
+            Free();
+            GC.SuppressFinalize(this);
+        }
+
+        /// <summary>
+        /// Destructor
+        /// </summary>
+        ~ExecutionEnginePool()
+        {
+            Free();
+        }
+    }
+}
\ No newline at end of file
@@ -12,5 +12,10 @@ echo "************************"
 echo "**      UNIT TEST     **"
 echo "************************"
 
+if [[ $TRAVIS_OS_NAME != 'osx' ]]; then
+    cd $SCRIPTPATH/../src
+    make test
+fi
+
 cd $SCRIPTPATH/../tests/
 dotnet test NeoSharp.VM.Interop.Tests --verbosity n
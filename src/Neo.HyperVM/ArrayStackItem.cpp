@@ -1,21 +1,296 @@
 #include "ArrayStackItem.h"
 #include "BoolStackItem.h"
+#include "IntegerStackItem.h"
 #include "StackItemHelper.h"
 #include "Stack.h"
+#include <algorithm>
 
 ArrayStackItem::ArrayStackItem(IStackItemCounter* counter) :
-	IStackItem(counter, EStackItemType::Array),
-	_list(std::list<IStackItem*>())
-{ }
+	ICompoundStackItem(counter, EStackItemType::Array),
+	_storage(new ArrayStorage())
+{
+	counter->MemoryInc(sizeof(ArrayStackItem) + sizeof(ArrayStorage));
+}
 
 ArrayStackItem::ArrayStackItem(IStackItemCounter* counter, bool isStruct) :
-	IStackItem(counter, (isStruct ? EStackItemType::Struct : EStackItemType::Array)),
-	_list(std::list<IStackItem*>())
-{ }
+	ICompoundStackItem(counter, (isStruct ? EStackItemType::Struct : EStackItemType::Array)),
+	_storage(new ArrayStorage())
+{
+	counter->MemoryInc(sizeof(ArrayStackItem) + sizeof(ArrayStorage));
+}
+
+ArrayStackItem::ArrayStackItem(IStackItemCounter* counter, bool isStruct, int32 count) :
+	ICompoundStackItem(counter, (isStruct ? EStackItemType::Struct : EStackItemType::Array)),
+	_storage(new ArrayStorage())
+{
+	// Filled with packed false, the counter must have been increased by the caller
+
+	this->_storage->Items.assign(count, PackBool(false));
+
+	counter->MemoryInc(sizeof(ArrayStackItem) + sizeof(ArrayStorage) + count * SlotSize);
+}
+
+ArrayStackItem::ArrayStackItem(IStackItemCounter* counter, EStackItemType type, ArrayStorage* storage) :
+	ICompoundStackItem(counter, type),
+	_storage(storage)
+{
+	storage->Owners++;
+	counter->MemoryInc(sizeof(ArrayStackItem));
+}
+
+// Packed slots
+
+bool ArrayStackItem::Pack(IStackItem* item, int64 &slot)
+{
+	// Only the items that nobody else holds, the caller will free them
+
+	if (item == nullptr || item->GetClaims() != 0)
+	{
+		return false;
+	}
+
+	switch (item->Type)
+	{
+	case EStackItemType::Bool:
+	{
+		slot = PackBool(((BoolStackItem*)item)->GetBoolean());
+		break;
+	}
+	case EStackItemType::Integer:
+	{
+		int64 value;
+
+		if (!((IntegerStackItem*)item)->GetInt64(value) || value < PackedMinValue || value > PackedMaxValue)
+		{
+			return false;
+		}
+
+		slot = PackInteger(value);
+		break;
+	}
+	default: return false;
+	}
+
+	// The slot takes the place of the item in the counter, the caller frees the item so the count doesn't grow
+
+	this->GetCounter()->ItemCounterInc();
+	return true;
+}
+
+IStackItem* ArrayStackItem::Box(int32 index)
+{
+	// The new item takes the place of the slot in the counter
+
+	int64 slot = this->_storage->Items[index];
+	IStackItem* item;
+
+	if ((slot & PackedBoolFlag) != 0)
+	{
+		item = new BoolStackItem(this->GetCounter(), Unpack(slot) != 0);
+	}
+	else
+	{
+		item = new IntegerStackItem(this->GetCounter(), Unpack(slot));
+	}
+
+	item->Claim();
+	this->_storage->Items[index] = FromItem(item);
+
+	return item;
+}
+
+void ArrayStackItem::FreeSlot(int64 slot)
+{
+	if (IsPacked(slot))
+	{
+		this->GetCounter()->ItemCounterDec();
+	}
+	else
+	{
+		auto item = ToItem(slot);
+		StackItemHelper::UnclaimAndFree(item);
+	}
+}
+
+int32 ArrayStackItem::EncodePacked(int64 slot, byte* output)
+{
+	// Same encoding as the boxed item
+
+	int64 value = Unpack(slot);
+
+	if ((slot & PackedBoolFlag) != 0)
+	{
+		if (value == 0) return 0;
+
+		output[0] = 0x01;
+		return 1;
+	}
+
+	for (int32 x = 0; x < 8; ++x)
+	{
+		output[x] = (byte)(value >> (x * 8));
+	}
+
+	byte sign = value < 0 ? 0xFF : 0x00;
+	int32 length = 8;
+
+	while (length > 1 && output[length - 1] == sign && (output[length - 2] & 0x80) == (sign & 0x80))
+	{
+		length--;
+	}
+
+	return length;
+}
+
+bool ArrayStackItem::SlotEquals(int64 a, int64 b)
+{
+	// Packed values are booleans or integers, both are equal to another primitive when their encodings are equal
+
+	byte da[9], db[9];
+	int32 la, lb;
+
+	if (IsPacked(a))
+	{
+		la = EncodePacked(a, da);
+	}
+	else
+	{
+		auto item = ToItem(a);
+
+		if (item == nullptr || item->Type == EStackItemType::Struct) return false;
+
+		la = item->ReadByteArraySize();
+		if (la < 0 || la > 9) return false;
+
+		la = item->ReadByteArray(da, 0, la);
+	}
+
+	if (IsPacked(b))
+	{
+		lb = EncodePacked(b, db);
+	}
+	else
+	{
+		auto item = ToItem(b);
+
+		if (item == nullptr || item->Type == EStackItemType::Struct) return false;
+
+		lb = item->ReadByteArraySize();
+		if (lb < 0 || lb > 9) return false;
+
+		lb = item->ReadByteArray(db, 0, lb);
+	}
+
+	if (la != lb) return false;
+
+	for (int32 x = 0; x < la; ++x)
+	{
+		if (da[x] != db[x]) return false;
+	}
+
+	return true;
+}
+
+// Copy on write
+
+ArrayStackItem* ArrayStackItem::Share()
+{
+	return new ArrayStackItem(this->GetCounter(), this->Type, this->_storage);
+}
+
+bool ArrayStackItem::IsSealed()
+{
+	// The items can be shared only if the nested structs are not referenced from outside
+
+	Stack<IStackItem> stack;
+	stack.Push(this);
+
+	while (stack.Count() > 0)
+	{
+		auto a = (ArrayStackItem*)stack.Pop();
+
+		for (auto it = a->_storage->Items.begin(); it != a->_storage->Items.end(); ++it)
+		{
+			if (IsPacked(*it))
+				continue;
+
+			auto item = ToItem(*it);
+
+			if (item == nullptr || item->Type != EStackItemType::Struct)
+				continue;
+
+			if (item->GetClaims() != 1)
+				return false;
+
+			// Shared storages were sealed when they were shared
+
+			if (!((ArrayStackItem*)item)->IsShared())
+				stack.Push(item);
+		}
+	}
+
+	return true;
+}
+
+void ArrayStackItem::Detach()
+{
+	auto shared = this->_storage;
+	auto storage = new ArrayStorage();
+
+	storage->Items.reserve(shared->Items.size());
+
+	for (int32 x = 0, m = (int32)shared->Items.size(); x < m; ++x)
+	{
+		// Both storages will reference the same item, so the packed values are boxed in the shared one
+
+		auto item = IsPacked(shared->Items[x]) ? this->Box(x) : ToItem(shared->Items[x]);
+
+		if (item != nullptr)
+		{
+			if (item->Type == EStackItemType::Struct)
+			{
+				item = ((ArrayStackItem*)item)->Share();
+			}
+
+			item->Claim();
+		}
+
+		storage->Items.push_back(FromItem(item));
+	}
+
+	shared->Owners--;
+	this->_storage = storage;
+
+	this->GetCounter()->MemoryInc(sizeof(ArrayStorage) + storage->Items.size() * SlotSize);
+}
+
+void ArrayStackItem::Release()
+{
+	if (this->_storage == nullptr) return;
+
+	if (--this->_storage->Owners == 0)
+	{
+		this->GetCounter()->MemoryDec(sizeof(ArrayStorage) + this->_storage->Items.size() * SlotSize);
+
+		for (auto it = this->_storage->Items.begin(); it != this->_storage->Items.end(); ++it)
+		{
+			this->FreeSlot(*it);
+		}
+
+		delete(this->_storage);
+	}
+
+	this->_storage = nullptr;
+}
 
 IStackItem* ArrayStackItem::Clone()
 {
-	auto ret = new ArrayStackItem(_counter, this->Type == EStackItemType::Struct);
+	if (this->IsShared() || this->IsSealed())
+	{
+		return this->Share();
+	}
+
+	auto ret = new ArrayStackItem(this->GetCounter(), this->Type == EStackItemType::Struct);
 
 	Stack<IStackItem> queue;
 
@@ -29,11 +304,13 @@ IStackItem* ArrayStackItem::Clone()
 
 		for (int32 x = 0, m = b->Count(); x < m; ++x)
 		{
+			// Packed values are boxed, so both arrays reference the same item
+
 			auto sb = b->Get(x);
 
 			if (sb->Type == EStackItemType::Struct)
 			{
-				auto sa = new ArrayStackItem(_counter, true);
+				auto sa = new ArrayStackItem(this->GetCounter(), true);
 				a->Add(sa);
 
 				queue.Insert(queue.Count(), sa);
@@ -56,7 +333,7 @@ bool ArrayStackItem::Equals(IStackItem* it)
 
 	// Different type (Array must be equal pointer)
 
-	if (it->Type != EStackItemType::Struct)
+	if (this->Type != EStackItemType::Struct || it->Type != EStackItemType::Struct)
 	{
 		return false;
 	}
@@ -73,37 +350,43 @@ bool ArrayStackItem::Equals(IStackItem* it)
 
 	while (stack1.Count() > 0)
 	{
-		auto a = stack1.Pop();
-		auto b = stack2.Pop();
+		auto sa = (ArrayStackItem*)stack1.Pop();
+		auto sb = (ArrayStackItem*)stack2.Pop();
 
-		if (a->Type == EStackItemType::Struct)
-		{
-			if (a == b) continue;
+		// Same storage, same items
 
-			auto sa = (ArrayStackItem*)a;
+		if (sa == sb || sa->_storage == sb->_storage) continue;
 
-			if (b->Type != EStackItemType::Struct) return false;
+		int32 count = sa->Count();
 
-			auto sb = (ArrayStackItem*)b;
+		if (count != sb->Count()) return false;
 
-			int32 sac = sa->Count();
-			int32 sbc = sb->Count();
-			
-			if (sac != sbc) return false;
+		for (int32 x = 0; x < count; ++x)
+		{
+			int64 slotA = sa->_storage->Items[x];
+			int64 slotB = sb->_storage->Items[x];
 
-			for (int32 x = 0; x < sac; x++) 
+			if (IsPacked(slotA) || IsPacked(slotB))
 			{
-				stack1.Push(sa->Get(x));
+				if (!SlotEquals(slotA, slotB)) return false;
+				continue;
 			}
 
-			for (int32 x = 0; x < sbc; x++)
+			auto a = ToItem(slotA);
+			auto b = ToItem(slotB);
+
+			if (a->Type == EStackItemType::Struct)
 			{
-				stack2.Push(sb->Get(x));
+				if (a == b) continue;
+				if (b->Type != EStackItemType::Struct) return false;
+
+				stack1.Push(a);
+				stack2.Push(b);
+			}
+			else
+			{
+				if (!a->Equals(b)) return false;
 			}
-		}
-		else
-		{
-			if (!a->Equals(b)) return false;
 		}
 	}
 
@@ -112,23 +395,27 @@ bool ArrayStackItem::Equals(IStackItem* it)
 
 // Read
 
-IStackItem* ArrayStackItem::Get(int32 index)
+IStackItem* ArrayStackItem::GetMutable(int32 index)
 {
-	if (index == 0)
-		return this->_list.front();
+	auto item = this->Get(index);
 
-	auto it = this->_list.begin();
-	std::advance(it, index);
+	// The item could be changed from outside, so it can't be shared anymore
+
+	if (this->IsShared() && item != nullptr && item->Type == EStackItemType::Struct)
+	{
+		this->Detach();
+		item = this->Get(index);
+	}
 
-	return (IStackItem*)*it;
+	return item;
 }
 
 int32 ArrayStackItem::IndexOf(IStackItem* item)
 {
 	int32 index = 0;
-	for (auto it = this->_list.begin(); it != this->_list.end(); ++it)
+	for (auto it = this->_storage->Items.begin(); it != this->_storage->Items.end(); ++it)
 	{
-		if ((IStackItem*)*it == item)
+		if (!IsPacked(*it) && ToItem(*it) == item)
 			return index;
 
 		++index;
@@ -140,80 +427,96 @@ int32 ArrayStackItem::IndexOf(IStackItem* item)
 
 void ArrayStackItem::Clear()
 {
-	for (auto it = this->_list.begin(); it != this->_list.end(); ++it)
+	if (this->IsShared())
 	{
-		auto ptr = (IStackItem*)*it;
-		StackItemHelper::UnclaimAndFree(ptr);
+		this->_storage->Owners--;
+		this->_storage = new ArrayStorage();
+		this->GetCounter()->MemoryInc(sizeof(ArrayStorage));
+		return;
 	}
 
-	this->_list.clear();
+	this->GetCounter()->MemoryDec(this->_storage->Items.size() * SlotSize);
+
+	for (auto it = this->_storage->Items.begin(); it != this->_storage->Items.end(); ++it)
+	{
+		this->FreeSlot(*it);
+	}
+
+	this->_storage->Items.clear();
+}
+
+void ArrayStackItem::Reverse()
+{
+	if (this->IsShared()) this->Detach();
+
+	std::reverse(this->_storage->Items.begin(), this->_storage->Items.end());
 }
 
 void ArrayStackItem::Insert(int32 index, IStackItem* item)
 {
-	if (item != nullptr)
-		item->Claim();
+	if (this->IsShared()) this->Detach();
 
-	if (index == 0)
-	{
-		this->_list.push_front(item);
-	}
-	else
+	int64 slot;
+
+	if (!this->Pack(item, slot))
 	{
-		auto it = this->_list.begin();
-		std::advance(it, index);
+		if (item != nullptr)
+			item->Claim();
 
-		this->_list.insert(it, item);
+		slot = FromItem(item);
 	}
+
+	this->_storage->Items.insert(this->_storage->Items.begin() + index, slot);
+	this->GetCounter()->MemoryInc(SlotSize);
 }
 
 void ArrayStackItem::Add(IStackItem* item)
 {
-	if (item != nullptr)
-		item->Claim();
+	if (this->IsShared()) this->Detach();
+
+	int64 slot;
+
+	if (!this->Pack(item, slot))
+	{
+		if (item != nullptr)
+			item->Claim();
+
+		slot = FromItem(item);
+	}
 
-	this->_list.push_back(item);
+	this->_storage->Items.push_back(slot);
+	this->GetCounter()->MemoryInc(SlotSize);
 }
 
 void ArrayStackItem::RemoveAt(int32 index)
 {
-	if (index == 0)
-	{
-		auto it = this->_list.front();
-		this->_list.pop_front();
-		StackItemHelper::UnclaimAndFree(it);
-	}
-	else
-	{
-		auto it = this->_list.begin();
-		std::advance(it, index);
+	if (this->IsShared()) this->Detach();
 
-		auto s = (IStackItem*)*it;
-		this->_list.erase(it);
-		StackItemHelper::UnclaimAndFree(s);
-	}
+	auto it = this->_storage->Items.begin() + index;
+	int64 slot = *it;
+
+	this->_storage->Items.erase(it);
+	this->GetCounter()->MemoryDec(SlotSize);
+
+	this->FreeSlot(slot);
 }
 
 void ArrayStackItem::Set(int32 index, IStackItem* item)
 {
-	if (item != nullptr)
-		item->Claim();
+	if (this->IsShared()) this->Detach();
+
+	int64 slot;
 
-	if (index == 0)
+	if (!this->Pack(item, slot))
 	{
-		auto it = this->_list.front();
-		this->_list.pop_front();
-		StackItemHelper::UnclaimAndFree(it);
-		this->_list.push_front(item);
+		if (item != nullptr)
+			item->Claim();
+
+		slot = FromItem(item);
 	}
-	else
-	{
-		auto it = this->_list.begin();
-		std::advance(it, index);
 
-		auto s = (IStackItem*)*it;
-		StackItemHelper::UnclaimAndFree(s);
+	int64 old = this->_storage->Items[index];
+	this->_storage->Items[index] = slot;
 
-		*it = item;
-	}
+	this->FreeSlot(old);
 }
\ No newline at end of file
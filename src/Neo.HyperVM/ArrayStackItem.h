@@ -1,56 +1,164 @@
 #pragma once
 
 #include "IStackItemCounter.h"
-#include "IStackItem.h"
-#include <list>
+#include "ICompoundStackItem.h"
+#include <stdint.h>
+#include <vector>
 
-class ArrayStackItem : public IStackItem
+class ArrayStackItem final : public ICompoundStackItem
 {
 private:
 
-	std::list<IStackItem*> _list;
+	friend class CycleCollector;
+	friend class StackItemCopier;
+
+	// Each slot is an item pointer, or a packed boolean or small integer (lowest bit set).
+	// A packed slot stands for an item that nobody else can reference, so it's counted
+	// as one item, and it's boxed in place when a reference to it is taken
+
+	static const int64 PackedFlag = 1;
+	static const int64 PackedBoolFlag = 2;
+	static const int64 PackedMinValue = -(1LL << 61);
+	static const int64 PackedMaxValue = (1LL << 61) - 1;
+
+	static inline bool IsPacked(int64 slot)
+	{
+		return (slot & PackedFlag) != 0;
+	}
+
+	static inline IStackItem* ToItem(int64 slot)
+	{
+		return (IStackItem*)(intptr_t)slot;
+	}
+
+	static inline int64 FromItem(IStackItem* item)
+	{
+		return (int64)(intptr_t)item;
+	}
+
+	static inline int64 PackBool(bool value)
+	{
+		return (value ? 4 : 0) | PackedBoolFlag | PackedFlag;
+	}
+
+	static inline int64 PackInteger(int64 value)
+	{
+		return (int64)((uint64)value << 2) | PackedFlag;
+	}
+
+	static inline int64 Unpack(int64 slot)
+	{
+		return slot >> 2;
+	}
+
+	static int32 EncodePacked(int64 slot, byte* output);
+	static bool SlotEquals(int64 a, int64 b);
+
+	// Items are shared between clones until one of them is modified
+
+	struct ArrayStorage
+	{
+		std::vector<int64> Items;
+		int32 Owners;
+
+		inline ArrayStorage() : Items(), Owners(1) { }
+	};
+
+	ArrayStorage* _storage;
+
+	// Memory accounted for each slot of a storage
+
+	static const int32 SlotSize = sizeof(int64);
+
+	inline bool IsShared()
+	{
+		return this->_storage->Owners > 1;
+	}
+
+	bool IsSealed();
+	void Detach();
+	void Release();
+	ArrayStackItem* Share();
+
+	bool Pack(IStackItem* item, int64 &slot);
+	IStackItem* Box(int32 index);
+	void FreeSlot(int64 slot);
+
+	ArrayStackItem(IStackItemCounter* counter, EStackItemType type, ArrayStorage* storage);
 
 public:
 
 	// Converters
 
 	inline bool GetBoolean() { return true; }
-	inline BigInteger* GetBigInteger() { return nullptr; }
+	inline const BigInteger* GetBigInteger(BigInteger &temp) { return nullptr; }
 	inline bool GetInt32(int32 &ret) { return false; }
+	inline bool GetInt64(int64 &ret) { return false; }
 	inline int32 ReadByteArray(byte* output, int32 sourceIndex, int32 count) { return -1; }
 	inline int32 ReadByteArraySize() { return -1; }
+	inline int32 GetByteArrayView(const byte* &data) { return -1; }
 
-	inline void Reverse()
-	{
-		this->_list.reverse();
-	}
+	void Reverse();
 
 	IStackItem* Clone();
 	bool Equals(IStackItem* it);
 
 	inline int32 Count()
 	{
-		return static_cast<int>(this->_list.size());
+		return static_cast<int>(this->_storage->Items.size());
+	}
+
+	// Packed slots are boxed first, so the item is held by the array like the others
+
+	inline IStackItem* Get(int32 index)
+	{
+		int64 slot = this->_storage->Items[index];
+
+		if (IsPacked(slot))
+		{
+			// Detach boxes the packed slots of the shared storage
+
+			if (this->IsShared())
+			{
+				this->Detach();
+				return ToItem(this->_storage->Items[index]);
+			}
+
+			return this->Box(index);
+		}
+
+		return ToItem(slot);
 	}
 
 	void Clear();
-	IStackItem* Get(int32 index);
+	IStackItem* GetMutable(int32 index);
 	void Add(IStackItem* item);
 	void Set(int32 index, IStackItem* item);
 	void Insert(int32 index, IStackItem* item);
 	void RemoveAt(int32 index);
 	int32 IndexOf(IStackItem* item);
 
+	// Hash
+
+	inline uint32 GetHash()
+	{
+		// Mutable content, Equals decide
+
+		return (uint32)this->Type;
+	}
+
 	// Constructor
 
 	ArrayStackItem(IStackItemCounter* counter);
 	ArrayStackItem(IStackItemCounter* counter, bool isStruct);
+	ArrayStackItem(IStackItemCounter* counter, bool isStruct, int32 count);
 
 	// Destructor
 
 	inline ~ArrayStackItem()
 	{
-		this->Clear();
+		this->Release();
+		this->GetCounter()->MemoryDec(sizeof(ArrayStackItem));
 	}
 
 	// Serialize
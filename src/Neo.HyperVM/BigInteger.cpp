@@ -1,10 +1,19 @@
 #include "BigInteger.h"
 #include "BigIntegerBuilder.h"
+#include "BigIntegerKernel.h"
+#include "ScratchBuffer.h"
 #include <string.h>
 
+const int32 ScratchLimbs = 2 * (MAX_BIGINTEGER_SIZE / 4) + 2;
+
+typedef ScratchBuffer<uint32, ScratchLimbs> ScratchBits;
+typedef ScratchBuffer<byte, ScratchLimbs * 4> ScratchBytes;
+
 // Constants
 
-const BigInteger BigInteger::Min = BigInteger(-1, new uint32[1]{ BigInteger::kuMaskHighBit }, 1);
+static uint32 MinBits[1] = { 0x80000000 };
+
+const BigInteger BigInteger::Min = BigInteger(-1, MinBits, 1);
 const BigInteger BigInteger::One = BigInteger(1);
 const BigInteger BigInteger::Zero = BigInteger(0);
 const BigInteger BigInteger::MinusOne = BigInteger(-1);
@@ -20,14 +29,13 @@ BigInteger::BigInteger(uint32 value) : _cachedSize(-1)
 	else
 	{
 		this->_sign = +1;
-		this->_bits = new uint32[1]{ value };
-		this->_bitsSize = 1;
+		this->SetBits(&value, 1);
 	}
 
 	// AssertValid();
 }
 
-BigInteger::BigInteger(int32 sign, uint32* rgu, int32 rguSize) : _cachedSize(-1)
+BigInteger::BigInteger(int32 sign, const uint32* rgu, int32 rguSize) : _cachedSize(-1)
 {
 	this->_sign = sign;
 
@@ -40,12 +48,13 @@ BigInteger::BigInteger(int32 sign, uint32* rgu, int32 rguSize) : _cachedSize(-1)
 		return;
 	}
 
-	this->_bitsSize = rguSize;
-	this->_bits = new uint32[rguSize];
+	this->SetBits(rgu, rguSize);
 
-	for (int32 x = 0; x < rguSize; ++x)
-		this->_bits[x] = rgu[x];
+	// AssertValid();
+}
 
+BigInteger::BigInteger() : _sign(0), _bits(nullptr), _bitsSize(0), _cachedSize(-1)
+{
 	// AssertValid();
 }
 
@@ -54,6 +63,38 @@ BigInteger::BigInteger(int32 value) : _sign(value), _bits(nullptr), _bitsSize(0)
 	// AssertValid();
 }
 
+BigInteger::BigInteger(int64 value) : _cachedSize(-1)
+{
+	if (value > Int32MinValue && value <= Int32MaxValue)
+	{
+		this->_sign = (int32)value;
+		this->_bits = nullptr;
+		this->_bitsSize = 0;
+
+		// AssertValid();
+		return;
+	}
+
+	uint64 magnitude;
+
+	if (value < 0)
+	{
+		this->_sign = -1;
+		magnitude = 0 - (uint64)value;
+	}
+	else
+	{
+		this->_sign = +1;
+		magnitude = (uint64)value;
+	}
+
+	uint32 bits[2] = { (uint32)magnitude, (uint32)(magnitude >> 32) };
+
+	this->SetBits(bits, bits[1] == 0 ? 1 : 2);
+
+	// AssertValid();
+}
+
 BigInteger::BigInteger(BigInteger* value) : _sign(value->_sign), _cachedSize(-1)
 {
 	if (value->_bits == nullptr || value->_bitsSize <= 0)
@@ -63,11 +104,7 @@ BigInteger::BigInteger(BigInteger* value) : _sign(value->_sign), _cachedSize(-1)
 	}
 	else
 	{
-		this->_bitsSize = value->_bitsSize;
-		this->_bits = new uint32[value->_bitsSize];
-
-		for (int32 x = 0; x < value->_bitsSize; ++x)
-			this->_bits[x] = value->_bits[x];
+		this->SetBits(value->_bits, value->_bitsSize);
 	}
 
 	// AssertValid();
@@ -82,16 +119,22 @@ BigInteger::BigInteger(const BigInteger &value) : _sign(value._sign), _cachedSiz
 	}
 	else
 	{
-		this->_bitsSize = value._bitsSize;
-		this->_bits = new uint32[value._bitsSize];
-
-		for (int32 x = 0; x < value._bitsSize; ++x)
-			this->_bits[x] = value._bits[x];
+		this->SetBits(value._bits, value._bitsSize);
 	}
 
 	// AssertValid();
 }
 
+BigInteger& BigInteger::operator=(const BigInteger &value)
+{
+	if (this != &value)
+	{
+		this->CopyInternal(value);
+	}
+
+	return *this;
+}
+
 BigInteger::BigInteger(uint32* value, int32 valueSize, bool negative) :_sign(0), _bits(nullptr), _bitsSize(0), _cachedSize(-1)
 {
 	if (value == nullptr)
@@ -122,11 +165,8 @@ BigInteger::BigInteger(uint32* value, int32 valueSize, bool negative) :_sign(0),
 		}
 		else
 		{
-			this->_bitsSize = len;
 			this->_sign = negative ? -1 : +1;
-			this->_bits = new uint32[len];
-			for (int32 x = 0; x < len; ++x)
-				this->_bits[x] = value[x];
+			this->SetBits(value, len);
 		}
 	}
 
@@ -157,8 +197,7 @@ BigInteger::BigInteger(uint32* value, int32 size) :_sign(0), _bits(nullptr), _bi
 	{
 		if ((int)value[0] < 0 && !isNegative)
 		{
-			this->_bits = new uint32[1]{ value[0] };
-			this->_bitsSize = 1;
+			this->SetBits(value, 1);
 			this->_sign = +1;
 		}
 		// handle the special cases where the BigInteger likely fits into _sign
@@ -181,20 +220,13 @@ BigInteger::BigInteger(uint32* value, int32 size) :_sign(0), _bits(nullptr), _bi
 		if (dwordCount != size)
 		{
 			this->_sign = +1;
-			this->_bitsSize = dwordCount;
-			this->_bits = new uint32[dwordCount];
-
-			for (int32 x = 0; x < dwordCount; ++x)
-				this->_bits[x] = value[x];
+			this->SetBits(value, dwordCount);
 		}
 		// no trimming is possible.  Assign value directly to _bits.  
 		else
 		{
 			this->_sign = +1;
-			this->_bitsSize = size;
-			this->_bits = new uint32[size];
-			for (int32 x = 0; x < size; ++x)
-				this->_bits[x] = value[x];
+			this->SetBits(value, size);
 		}
 
 		// AssertValid();
@@ -229,20 +261,13 @@ BigInteger::BigInteger(uint32* value, int32 size) :_sign(0), _bits(nullptr), _bi
 	else if (len != size)
 	{
 		this->_sign = -1;
-		this->_bitsSize = len;
-		this->_bits = new uint32[len];
-
-		for (int32 x = 0; x < len; ++x)
-			this->_bits[x] = value[x];
+		this->SetBits(value, len);
 	}
 	// no trimming is possible.  Assign value directly to _bits.  
 	else
 	{
 		this->_sign = -1;
-		this->_bitsSize = size;
-		this->_bits = new uint32[size];
-		for (int32 x = 0; x < size; ++x)
-			this->_bits[x] = value[x];
+		this->SetBits(value, size);
 	}
 
 	//AssertValid();
@@ -286,9 +311,10 @@ BigInteger::BigInteger(byte* value, int32 byteCount) : _sign(0), _bits(nullptr),
 			// can be naively packed into 4 bytes (due to the leading 0x0)
 			// it overflows into the int32 sign bit
 
-			this->_bits = new uint32[1]{ (uint32)this->_sign };
+			uint32 bits = (uint32)this->_sign;
+
+			this->SetBits(&bits, 1);
 			this->_sign = +1;
-			this->_bitsSize = 1;
 
 			// AssertValid();
 			return;
@@ -296,8 +322,7 @@ BigInteger::BigInteger(byte* value, int32 byteCount) : _sign(0), _bits(nullptr),
 		if (_sign == Int32MinValue)
 		{
 			this->_sign = -1;
-			this->_bits = new uint32[1]{ BigInteger::kuMaskHighBit };
-			this->_bitsSize = 1;
+			this->SetBits(MinBits, 1);
 
 			// AssertValid();
 			return;
@@ -308,7 +333,8 @@ BigInteger::BigInteger(byte* value, int32 byteCount) : _sign(0), _bits(nullptr),
 		int32 unalignedBytes = byteCount % 4;
 		int32 dwordCount = byteCount / 4 + (unalignedBytes == 0 ? 0 : 1);
 		bool isZero = true;
-		uint32* val = new uint32[dwordCount]();
+		ScratchBits val(dwordCount);
+		memset(val, 0, dwordCount * sizeof(uint32));
 
 		// Copy all dwords, except but don't do the last one if it's not a full four bytes
 
@@ -361,8 +387,7 @@ BigInteger::BigInteger(byte* value, int32 byteCount) : _sign(0), _bits(nullptr),
 					else if (val[0] == kuMaskHighBit) // abs(Int32.MinValue)
 					{
 						this->_sign = -1;
-						this->_bits = new uint32[1]{ BigInteger::kuMaskHighBit };
-						this->_bitsSize = 1;
+						this->SetBits(MinBits, 1);
 					}
 					else
 					{
@@ -372,31 +397,20 @@ BigInteger::BigInteger(byte* value, int32 byteCount) : _sign(0), _bits(nullptr),
 				else if (len != dwordCount)
 				{
 					this->_sign = -1;
-					this->_bits = new uint32[len];
-					this->_bitsSize = len;
-
-					for (int32 x = 0; x < len; ++x)
-						this->_bits[x] = val[x];
+					this->SetBits(val, len);
 				}
 				else
 				{
 					this->_sign = -1;
-					this->_bits = val;
-					this->_bitsSize = dwordCount;
+					this->SetBits(val, dwordCount);
 				}
 			}
 			else
 			{
 				this->_sign = +1;
-				this->_bits = val;
-				this->_bitsSize = dwordCount;
+				this->SetBits(val, dwordCount);
 			}
 		}
-
-		// Free resources
-
-		if (this->_bits != val)
-			delete[](val);
 	}
 
 	// AssertValid();
@@ -404,23 +418,13 @@ BigInteger::BigInteger(byte* value, int32 byteCount) : _sign(0), _bits(nullptr),
 
 void BigInteger::CopyInternal(const BigInteger &reg)
 {
+	this->FreeBits();
 	this->_sign = reg._sign;
-	this->_bitsSize = reg._bitsSize;
+	this->_cachedSize = -1;
 
-	if (this->_bitsSize > 0)
+	if (reg._bitsSize > 0)
 	{
-		this->_bits = new uint32[this->_bitsSize];
-
-		for (int32 x = 0; x < this->_bitsSize; ++x)
-			this->_bits[x] = reg._bits[x];
-	}
-	else
-	{
-		if (this->_bits != nullptr)
-		{
-			delete[]this->_bits;
-			this->_bits = nullptr;
-		}
+		this->SetBits(reg._bits, reg._bitsSize);
 	}
 }
 
@@ -453,12 +457,7 @@ void BigInteger::DangerousMakeTwosComplement(uint32* d, int32 dSize)
 	// return d;
 }
 
-BigInteger* BigInteger::Clone()
-{
-	return new BigInteger(this->_sign, this->_bits, this->_bitsSize);
-}
-
-int32 BigInteger::Length(uint32* rgu, int32 size)
+int32 BigInteger::Length(const uint32* rgu, int32 size)
 {
 	if (rgu[size - 1] != 0)
 		return size;
@@ -467,7 +466,7 @@ int32 BigInteger::Length(uint32* rgu, int32 size)
 	return size - 1;
 }
 
-int32 BigInteger::GetDiffLength(uint32* rgu1, uint32* rgu2, int32 cu)
+int32 BigInteger::GetDiffLength(const uint32* rgu1, const uint32* rgu2, int32 cu)
 {
 	for (int32 iv = cu; --iv >= 0; )
 	{
@@ -477,35 +476,29 @@ int32 BigInteger::GetDiffLength(uint32* rgu1, uint32* rgu2, int32 cu)
 	return 0;
 }
 
-int32 BigInteger::ToUInt32Array(uint32* &output)
+int32 BigInteger::ToUInt32Array(uint32* output) const
 {
-	if (this->_bits == nullptr && this->_sign == 0)
+	// The output must have room for the limbs and the sign extension
+
+	if (this->_bits == nullptr)
 	{
-		output = new uint32[1]{ 0 };
+		output[0] = (uint32)this->_sign;
 		return 1;
 	}
 
-	int32 dwords_size;
-	uint32* dwords;
+	int32 dwords_size = this->_bitsSize;
 	uint32 highDWord;
 
-	if (this->_bits == nullptr)
-	{
-		dwords = new uint32[1]{ (uint32)this->_sign };
-		dwords_size = 1;
-		highDWord = (this->_sign < 0) ? UInt32MaxValue : 0;
-	}
-	else if (_sign == -1)
+	for (int32 x = 0; x < dwords_size; ++x)
+		output[x] = this->_bits[x];
+
+	if (_sign == -1)
 	{
-		dwords = this->_bits;
-		dwords_size = this->_bitsSize;
-		this->DangerousMakeTwosComplement(dwords, dwords_size);  // mutates dwords
+		this->DangerousMakeTwosComplement(output, dwords_size);  // mutates the copy
 		highDWord = UInt32MaxValue;
 	}
 	else
 	{
-		dwords = this->_bits;
-		dwords_size = this->_bitsSize;
 		highDWord = 0;
 	}
 
@@ -513,49 +506,43 @@ int32 BigInteger::ToUInt32Array(uint32* &output)
 	int32 msb;
 	for (msb = dwords_size - 1; msb > 0; msb--)
 	{
-		if (dwords[msb] != highDWord) break;
+		if (output[msb] != highDWord) break;
 	}
 	// ensure high bit is 0 if positive, 1 if negative
-	bool needExtraByte = (dwords[msb] & 0x80000000) != (highDWord & 0x80000000);
+	bool needExtraByte = (output[msb] & 0x80000000) != (highDWord & 0x80000000);
 
 	int32 trimmed_size = msb + 1 + (needExtraByte ? 1 : 0);
-	output = new uint32[trimmed_size];
-
-	for (int32 x = 0, m = msb + 1; x < m; ++x)
-		output[x] = dwords[x];
 
 	if (needExtraByte) output[trimmed_size - 1] = highDWord;
 
-	// Clean
-
-	if (dwords != this->_bits)
-		delete[]dwords;
-
 	return trimmed_size;
 }
 
-BigInteger* BigInteger::Or(BigInteger* bi)
+void BigInteger::Or(const BigInteger &bi, BigInteger &ret) const
 {
-	if (bi == nullptr || bi->_sign == 0) // IsZero
+	if (bi._sign == 0) // IsZero
 	{
-		return this->Clone();
+		ret = *this;
+		return;
 	}
 
 	if (this->_sign == 0) // IsZero
 	{
-		return bi->Clone();
+		ret = bi;
+		return;
 	}
 
-	uint32* x, *y, *z;
+	ScratchBits x(this->_bitsSize + 2);
+	ScratchBits y(bi._bitsSize + 2);
 
 	int32 sizex = this->ToUInt32Array(x);
-	int32 sizey = bi->ToUInt32Array(y);
+	int32 sizey = bi.ToUInt32Array(y);
 	int32 sizez = sizex > sizey ? sizex : sizey;
 
-	z = new uint32[sizez];
+	ScratchBits z(sizez);
 
 	uint32 xExtend = (this->_sign < 0) ? UInt32MaxValue : 0;
-	uint32 yExtend = (bi->_sign < 0) ? UInt32MaxValue : 0;
+	uint32 yExtend = (bi._sign < 0) ? UInt32MaxValue : 0;
 
 	uint32 xu, yu;
 
@@ -566,37 +553,34 @@ BigInteger* BigInteger::Or(BigInteger* bi)
 		z[i] = xu | yu;
 	}
 
-	BigInteger* ret = new BigInteger(z, sizez);
-
-	delete[]x;
-	delete[]y;
-	delete[]z;
-
-	return ret;
+	ret = BigInteger(z, sizez);
 }
 
-BigInteger* BigInteger::Xor(BigInteger* bi)
+void BigInteger::Xor(const BigInteger &bi, BigInteger &ret) const
 {
-	if (bi == nullptr || bi->_sign == 0) // IsZero
+	if (bi._sign == 0) // IsZero
 	{
-		return this->Clone();
+		ret = *this;
+		return;
 	}
 
 	if (this->_sign == 0) // IsZero
 	{
-		return bi->Clone();
+		ret = bi;
+		return;
 	}
 
-	uint32* x, *y, *z;
+	ScratchBits x(this->_bitsSize + 2);
+	ScratchBits y(bi._bitsSize + 2);
 
 	int32 sizex = this->ToUInt32Array(x);
-	int32 sizey = bi->ToUInt32Array(y);
+	int32 sizey = bi.ToUInt32Array(y);
 	int32 sizez = sizex > sizey ? sizex : sizey;
 
-	z = new uint32[sizez];
+	ScratchBits z(sizez);
 
 	uint32 xExtend = (this->_sign < 0) ? UInt32MaxValue : 0;
-	uint32 yExtend = (bi->_sign < 0) ? UInt32MaxValue : 0;
+	uint32 yExtend = (bi._sign < 0) ? UInt32MaxValue : 0;
 
 	uint32 xu, yu;
 
@@ -607,26 +591,22 @@ BigInteger* BigInteger::Xor(BigInteger* bi)
 		z[i] = xu ^ yu;
 	}
 
-	BigInteger* ret = new BigInteger(z, sizez);
-
-	delete[]x;
-	delete[]y;
-	delete[]z;
-
-	return ret;
+	ret = BigInteger(z, sizez);
 }
 
-bool BigInteger::GetPartsForBitManipulation(BigInteger* x, uint32* &xd, int32 &xl)
+bool BigInteger::GetPartsForBitManipulation(const BigInteger* x, uint32* xd, int32 &xl)
 {
+	// The magnitude is copied to xd, that must have room for one limb at least
+
 	if (x->_bits == nullptr)
 	{
 		if (x->_sign < 0)
 		{
-			xd = new uint32[1]{ (uint32)-x->_sign };
+			xd[0] = (uint32)-x->_sign;
 		}
 		else
 		{
-			xd = new uint32[1]{ (uint32)x->_sign };
+			xd[0] = (uint32)x->_sign;
 		}
 
 		xl = 1;
@@ -635,36 +615,29 @@ bool BigInteger::GetPartsForBitManipulation(BigInteger* x, uint32* &xd, int32 &x
 	{
 		xl = x->_bitsSize;
 
-		if (xl > 0)
-		{
-			xd = new uint32[xl];
-			for (int32 y = 0; y < xl; y++)
-				xd[y] = x->_bits[y];
-		}
-		else
-		{
-			xd = nullptr;
-		}
+		for (int32 y = 0; y < xl; y++)
+			xd[y] = x->_bits[y];
 	}
 
 	return x->_sign < 0;
 }
 
-BigInteger* BigInteger::Shl(int32 shift)
+void BigInteger::Shl(int32 shift, BigInteger &ret) const
 {
-	if (shift == 0) return this->Clone();
-	else if (shift == Int32MinValue) return this->Shr(Int32MaxValue)->Shr(1);
-	else if (shift < 0) return this->Shr(-shift);
+	if (shift == 0) { ret = *this; return; }
+	else if (shift == Int32MinValue) { this->Shr(Int32MaxValue, ret); ret.Shr(1, ret); return; }
+	else if (shift < 0) { this->Shr(-shift, ret); return; }
 
 	int32 digitShift = shift / kcbitUint;
 	int32 smallShift = shift - (digitShift * kcbitUint);
 
 	int32 xl;
-	uint32* xd;
+	ScratchBits xd(this->_bitsSize + 1);
 	bool negx = this->GetPartsForBitManipulation(this, xd, xl);
 
 	int32 zl = xl + digitShift + 1;
-	uint32* zd = new uint32[zl]();
+	ScratchBits zd(zl);
+	memset(zd, 0, zl * sizeof(uint32));
 
 	if (smallShift == 0)
 	{
@@ -686,23 +659,19 @@ BigInteger* BigInteger::Shl(int32 shift)
 		zd[i + digitShift] = carry;
 	}
 
-	delete[](xd);
-	BigInteger* ret = new BigInteger(zd, zl, negx);
-	delete[](zd);
-
-	return ret;
+	ret = BigInteger(zd, zl, negx);
 }
 
-BigInteger* BigInteger::Shr(int32 shift)
+void BigInteger::Shr(int32 shift, BigInteger &ret) const
 {
-	if (shift == 0) return this->Clone();
-	else if (shift == Int32MinValue) return this->Shl(Int32MaxValue)->Shl(1);
-	else if (shift < 0) return this->Shl(-shift);
+	if (shift == 0) { ret = *this; return; }
+	else if (shift == Int32MinValue) { this->Shl(Int32MaxValue, ret); ret.Shl(1, ret); return; }
+	else if (shift < 0) { this->Shl(-shift, ret); return; }
 
 	int32 digitShift = shift / kcbitUint;
 	int32 smallShift = shift - (digitShift * kcbitUint);
 
-	uint32* xd;
+	ScratchBits xd(this->_bitsSize + 1);
 	int32 xl;
 	bool negx = this->GetPartsForBitManipulation(this, xd, xl);
 
@@ -710,7 +679,8 @@ BigInteger* BigInteger::Shr(int32 shift)
 	{
 		if (shift >= (kcbitUint * xl))
 		{
-			return new BigInteger(BigInteger::MinusOne);
+			ret = BigInteger::MinusOne;
+			return;
 		}
 
 		// This version don't require this copy, because `GetPartsForBitManipulation` always return a copy
@@ -727,7 +697,7 @@ BigInteger* BigInteger::Shr(int32 shift)
 
 	int32 zl = xl - digitShift;
 	if (zl < 0) zl = 0;
-	uint32* zd = new uint32[zl];
+	ScratchBits zd(zl);
 
 	if (smallShift == 0)
 	{
@@ -757,30 +727,28 @@ BigInteger* BigInteger::Shr(int32 shift)
 		this->DangerousMakeTwosComplement(zd, zl); // mutates zd
 	}
 
-	delete[](xd);
-	BigInteger* ret = new BigInteger(zd, zl, negx);
-	delete[](zd);
-
-	return ret;
+	ret = BigInteger(zd, zl, negx);
 }
 
-BigInteger* BigInteger::And(BigInteger* bi)
+void BigInteger::And(const BigInteger &bi, BigInteger &ret) const
 {
-	if (bi == nullptr || bi->_sign == 0 || this->_sign == 0) // IsZero
+	if (bi._sign == 0 || this->_sign == 0) // IsZero
 	{
-		return new BigInteger(BigInteger::Zero);
+		ret = BigInteger::Zero;
+		return;
 	}
 
-	uint32* x, *y, *z;
+	ScratchBits x(this->_bitsSize + 2);
+	ScratchBits y(bi._bitsSize + 2);
 
 	int32 sizex = this->ToUInt32Array(x);
-	int32 sizey = bi->ToUInt32Array(y);
+	int32 sizey = bi.ToUInt32Array(y);
 	int32 sizez = sizex > sizey ? sizex : sizey;
 
-	z = new uint32[sizez];
+	ScratchBits z(sizez);
 
 	uint32 xExtend = (this->_sign < 0) ? UInt32MaxValue : 0;
-	uint32 yExtend = (bi->_sign < 0) ? UInt32MaxValue : 0;
+	uint32 yExtend = (bi._sign < 0) ? UInt32MaxValue : 0;
 
 	uint32 xu, yu;
 
@@ -791,28 +759,35 @@ BigInteger* BigInteger::And(BigInteger* bi)
 		z[i] = xu & yu;
 	}
 
-	BigInteger* ret = new BigInteger(z, sizez);
-
-	delete[]x;
-	delete[]y;
-	delete[]z;
-
-	return ret;
+	ret = BigInteger(z, sizez);
 }
 
-BigInteger* BigInteger::Div(BigInteger* bi)
+bool BigInteger::Div(const BigInteger &bi, BigInteger &ret) const
 {
 	// dividend.AssertValid();
 	// divisor.AssertValid();
 
-	if (bi->_sign == 0) // IsZero
+	if (bi._sign == 0) // IsZero
 	{
-		return nullptr;
+		return false;
 	}
 
+#ifdef BIGINTEGER_KERNEL64
+	uint32 xs, ys;
+	const uint32* x;
+	const uint32* y;
+	int32 xl = this->GetMagnitude(xs, x);
+	int32 yl = bi.GetMagnitude(ys, y);
+
+	int32 ql, rl;
+	ScratchBits q(xl), r(yl);
+	BigIntegerKernel::DivRem(x, xl, y, yl, q, ql, r, rl);
+
+	ret = BigInteger(q, ql, this->GetSign() != bi.GetSign());
+#else
 	int32 sign = +1;
 	BigIntegerBuilder regNum(this->_sign, this->_bits, this->_bitsSize, sign);
-	BigIntegerBuilder regDen(bi->_sign, bi->_bits, bi->_bitsSize, sign);
+	BigIntegerBuilder regDen(bi._sign, bi._bits, bi._bitsSize, sign);
 
 	regNum.Div(regDen);
 
@@ -820,17 +795,31 @@ BigInteger* BigInteger::Div(BigInteger* bi)
 	uint32* bits;
 	regNum.GetInteger(sign, bits, bitSize);
 
-	return new BigInteger(sign, bits, bitSize);
+	ret = BigInteger(sign, bits, bitSize);
+#endif
+	return true;
 }
 
-BigInteger* BigInteger::Mul(BigInteger* bi)
+void BigInteger::Mul(const BigInteger &bi, BigInteger &ret) const
 {
 	// left.AssertValid();
 	// right.AssertValid();
 
+#ifdef BIGINTEGER_KERNEL64
+	uint32 xs, ys;
+	const uint32* x;
+	const uint32* y;
+	int32 xl = this->GetMagnitude(xs, x);
+	int32 yl = bi.GetMagnitude(ys, y);
+
+	ScratchBits z(xl + yl);
+	int32 zl = BigIntegerKernel::Mul(x, xl, y, yl, z);
+
+	ret = BigInteger(z, zl, this->GetSign() != bi.GetSign());
+#else
 	int32 sign = +1;
 	BigIntegerBuilder reg1(this->_sign, this->_bits, this->_bitsSize, sign);
-	BigIntegerBuilder reg2(bi->_sign, bi->_bits, bi->_bitsSize, sign);
+	BigIntegerBuilder reg2(bi._sign, bi._bits, bi._bitsSize, sign);
 
 	reg1.Mul(reg2);
 
@@ -838,23 +827,39 @@ BigInteger* BigInteger::Mul(BigInteger* bi)
 	uint32* bits;
 	reg1.GetInteger(sign, bits, bitSize);
 
-	return new BigInteger(sign, bits, bitSize);
+	ret = BigInteger(sign, bits, bitSize);
+#endif
 }
 
-BigInteger* BigInteger::Mod(BigInteger* bi)
+bool BigInteger::Mod(const BigInteger &bi, BigInteger &ret) const
 {
 	// dividend.AssertValid();
 	// divisor.AssertValid();
 
-	if (bi->_sign == 0) // IsZero
+	if (bi._sign == 0) // IsZero
 	{
-		return nullptr;
+		return false;
 	}
 
+#ifdef BIGINTEGER_KERNEL64
+	uint32 xs, ys;
+	const uint32* x;
+	const uint32* y;
+	int32 xl = this->GetMagnitude(xs, x);
+	int32 yl = bi.GetMagnitude(ys, y);
+
+	int32 ql, rl;
+	ScratchBits q(xl), r(yl);
+	BigIntegerKernel::DivRem(x, xl, y, yl, q, ql, r, rl);
+
+	// The remainder takes the sign of the dividend
+
+	ret = BigInteger(r, rl, this->GetSign() < 0);
+#else
 	int32 signNum = +1;
 	int32 signDen = +1;
 	BigIntegerBuilder regNum(this->_sign, this->_bits, this->_bitsSize, signNum);
-	BigIntegerBuilder regDen(bi->_sign, bi->_bits, bi->_bitsSize, signDen);
+	BigIntegerBuilder regDen(bi._sign, bi._bits, bi._bitsSize, signDen);
 
 	regNum.Mod(regDen);
 
@@ -862,29 +867,36 @@ BigInteger* BigInteger::Mod(BigInteger* bi)
 	uint32* bits;
 	regNum.GetInteger(signNum, bits, bitSize);
 
-	return new BigInteger(signNum, bits, bitSize);
+	ret = BigInteger(signNum, bits, bitSize);
+#endif
+	return true;
 }
 
-BigInteger* BigInteger::Add(BigInteger* bi)
+void BigInteger::Add(const BigInteger &bi, BigInteger &ret) const
 {
 	// left.AssertValid();
 	// right.AssertValid();
 
-	if (bi->_sign == 0) // IsZero
+	if (bi._sign == 0) // IsZero
 	{
-		return this->Clone();
+		ret = *this;
+		return;
 	}
 
 	if (this->_sign == 0) // IsZero
 	{
-		return bi->Clone();
+		ret = bi;
+		return;
 	}
 
+#ifdef BIGINTEGER_KERNEL64
+	this->AddSigned(bi, bi.GetSign(), ret);
+#else
 	int32 sign1 = +1;
 	int32 sign2 = +1;
 
 	BigIntegerBuilder reg1(this->_sign, this->_bits, this->_bitsSize, sign1);
-	BigIntegerBuilder reg2(bi->_sign, bi->_bits, bi->_bitsSize, sign2);
+	BigIntegerBuilder reg2(bi._sign, bi._bits, bi._bitsSize, sign2);
 
 	if (sign1 == sign2)
 		reg1.Add(reg2);
@@ -895,30 +907,36 @@ BigInteger* BigInteger::Add(BigInteger* bi)
 	uint32* bits;
 	reg1.GetInteger(sign1, bits, bitSize);
 
-	return new BigInteger(sign1, bits, bitSize);
+	ret = BigInteger(sign1, bits, bitSize);
+#endif
 }
 
-BigInteger* BigInteger::Sub(BigInteger* bi)
+void BigInteger::Sub(const BigInteger &bi, BigInteger &ret) const
 {
 	// left.AssertValid();
 	// right.AssertValid();
 
-	if (bi->_sign == 0) // IsZero
+	if (bi._sign == 0) // IsZero
 	{
-		return this->Clone();
+		ret = *this;
+		return;
 	}
 
 	if (this->_sign == 0) // IsZero
 	{
 		// negate
-		return bi->Negate();
+		bi.Negate(ret);
+		return;
 	}
 
+#ifdef BIGINTEGER_KERNEL64
+	this->AddSigned(bi, -bi.GetSign(), ret);
+#else
 	int32 sign1 = +1;
 	int32 sign2 = -1;
 
 	BigIntegerBuilder reg1(this->_sign, this->_bits, this->_bitsSize, sign1);
-	BigIntegerBuilder reg2(bi->_sign, bi->_bits, bi->_bitsSize, sign2);
+	BigIntegerBuilder reg2(bi._sign, bi._bits, bi._bitsSize, sign2);
 
 	if (sign1 == sign2)
 		reg1.Add(reg2);
@@ -929,74 +947,134 @@ BigInteger* BigInteger::Sub(BigInteger* bi)
 	uint32* bits;
 	reg1.GetInteger(sign1, bits, bitSize);
 
-	return new BigInteger(sign1, bits, bitSize);
+	ret = BigInteger(sign1, bits, bitSize);
+#endif
 }
 
-BigInteger* BigInteger::Negate()
+#ifdef BIGINTEGER_KERNEL64
+void BigInteger::AddSigned(const BigInteger &bi, int32 biSign, BigInteger &ret) const
 {
-	return new BigInteger(-this->_sign, this->_bits, this->_bitsSize);
+	// this + |bi| * biSign, both operands are non zero
+
+	uint32 xs, ys;
+	const uint32* x;
+	const uint32* y;
+	int32 xl = this->GetMagnitude(xs, x);
+	int32 yl = bi.GetMagnitude(ys, y);
+	int32 sign = this->GetSign();
+
+	if (sign == biSign)
+	{
+		ScratchBits z((xl > yl ? xl : yl) + 1);
+		int32 zl = BigIntegerKernel::Add(x, xl, y, yl, z);
+
+		ret = BigInteger(z, zl, sign < 0);
+		return;
+	}
+
+	int32 cmp = BigIntegerKernel::Compare(x, xl, y, yl);
+
+	if (cmp == 0)
+	{
+		ret = BigInteger::Zero;
+		return;
+	}
+
+	if (cmp > 0)
+	{
+		ScratchBits z(xl);
+		int32 zl = BigIntegerKernel::Sub(x, xl, y, yl, z);
+
+		ret = BigInteger(z, zl, sign < 0);
+	}
+	else
+	{
+		ScratchBits z(yl);
+		int32 zl = BigIntegerKernel::Sub(y, yl, x, xl, z);
+
+		ret = BigInteger(z, zl, biSign < 0);
+	}
 }
+#endif
 
-BigInteger* BigInteger::Invert()
+int32 BigInteger::GetMagnitude(uint32 &small, const uint32* &bits) const
 {
-	BigInteger* add = new BigInteger(BigInteger::One);
-	BigInteger* ret = Add(add);
-	delete(add);
-
-	// Negate
-	BigInteger* realRet = new BigInteger(-ret->_sign, ret->_bits, ret->_bitsSize);
-	delete(ret);
-	return realRet;
+	// Limbs of the absolute value, small holds the packed ones
+
+	if (this->_bits != nullptr)
+	{
+		bits = this->_bits;
+		return this->_bitsSize;
+	}
+
+	small = this->_sign < 0 ? 0 - (uint32)this->_sign : (uint32)this->_sign;
+	bits = &small;
+	return this->_sign == 0 ? 0 : 1;
 }
 
-BigInteger* BigInteger::Abs()
+void BigInteger::Negate(BigInteger &ret) const
+{
+	ret = BigInteger(-this->_sign, this->_bits, this->_bitsSize);
+}
+
+void BigInteger::Invert(BigInteger &ret) const
+{
+	// -(x + 1)
+
+	this->Add(BigInteger::One, ret);
+	ret.Negate(ret);
+}
+
+void BigInteger::Abs(BigInteger &ret) const
 {
 	if (this->CompareTo(BigInteger::Zero) >= 0)
-		return this->Clone();
+	{
+		ret = *this;
+		return;
+	}
 
-	return new BigInteger(-this->_sign, this->_bits, this->_bitsSize);
+	this->Negate(ret);
 }
 
-int32 BigInteger::CompareTo(const BigInteger &bi)
+int32 BigInteger::CompareEncoding(const byte* x, int32 xl, const byte* y, int32 yl)
 {
-	// AssertValid();
-	// other.AssertValid();
+	// The sign is in the high bit of the last byte, the empty encoding is zero
 
-	if ((this->_sign ^ bi._sign) < 0)
+	bool xNegative = xl > 0 && (x[xl - 1] & 0x80) != 0;
+	bool yNegative = yl > 0 && (y[yl - 1] & 0x80) != 0;
+
+	if (xNegative != yNegative)
 	{
-		// Different signs, so the comparison is easy.
-		return this->_sign < 0 ? -1 : +1;
+		return xNegative ? -1 : +1;
 	}
 
-	// Same signs
-	if (this->_bits == nullptr)
-	{
-		if (bi._bits == nullptr)
-			return this->_sign < bi._sign ? -1 : this->_sign > bi._sign ? +1 : 0;
+	// Without the sign extension, a longer positive is bigger and a longer negative is smaller
 
-		return -bi._sign;
-	}
+	byte extension = xNegative ? 0xFF : 0x00;
 
-	int32 cuThis, cuOther;
-	if (bi._bits == nullptr || (cuThis = Length(this->_bits, this->_bitsSize)) > (cuOther = Length(bi._bits, bi._bitsSize)))
-		return this->_sign;
+	while (xl > 0 && x[xl - 1] == extension) --xl;
+	while (yl > 0 && y[yl - 1] == extension) --yl;
 
-	if (cuThis < cuOther)
-		return -this->_sign;
+	if (xl != yl)
+	{
+		return (xl < yl) != xNegative ? -1 : +1;
+	}
 
-	int32 cuDiff = GetDiffLength(this->_bits, bi._bits, cuThis);
-	if (cuDiff == 0)
-		return 0;
+	for (int32 i = xl - 1; i >= 0; --i)
+	{
+		if (x[i] != y[i])
+			return x[i] < y[i] ? -1 : +1;
+	}
 
-	return this->_bits[cuDiff - 1] < bi._bits[cuDiff - 1] ? -this->_sign : this->_sign;
+	return 0;
 }
 
-int32 BigInteger::CompareTo(BigInteger* bi)
+int32 BigInteger::CompareTo(const BigInteger &bi) const
 {
 	// AssertValid();
 	// other.AssertValid();
 
-	if ((this->_sign ^ bi->_sign) < 0)
+	if ((this->_sign ^ bi._sign) < 0)
 	{
 		// Different signs, so the comparison is easy.
 		return this->_sign < 0 ? -1 : +1;
@@ -1005,27 +1083,27 @@ int32 BigInteger::CompareTo(BigInteger* bi)
 	// Same signs
 	if (this->_bits == nullptr)
 	{
-		if (bi->_bits == nullptr)
-			return this->_sign < bi->_sign ? -1 : this->_sign > bi->_sign ? +1 : 0;
+		if (bi._bits == nullptr)
+			return this->_sign < bi._sign ? -1 : this->_sign > bi._sign ? +1 : 0;
 
-		return -bi->_sign;
+		return -bi._sign;
 	}
 
 	int32 cuThis, cuOther;
-	if (bi->_bits == nullptr || (cuThis = Length(this->_bits, this->_bitsSize)) > (cuOther = Length(bi->_bits, bi->_bitsSize)))
+	if (bi._bits == nullptr || (cuThis = Length(this->_bits, this->_bitsSize)) > (cuOther = Length(bi._bits, bi._bitsSize)))
 		return this->_sign;
 
 	if (cuThis < cuOther)
 		return -this->_sign;
 
-	int32 cuDiff = GetDiffLength(this->_bits, bi->_bits, cuThis);
+	int32 cuDiff = GetDiffLength(this->_bits, bi._bits, cuThis);
 	if (cuDiff == 0)
 		return 0;
 
-	return this->_bits[cuDiff - 1] < bi->_bits[cuDiff - 1] ? -this->_sign : this->_sign;
+	return this->_bits[cuDiff - 1] < bi._bits[cuDiff - 1] ? -this->_sign : this->_sign;
 }
 
-bool BigInteger::ToInt32(int32 &ret)
+bool BigInteger::ToInt32(int32 &ret) const
 {
 	// value.AssertValid();
 	if (this->_bits == nullptr)
@@ -1058,12 +1136,75 @@ bool BigInteger::ToInt32(int32 &ret)
 	}
 }
 
-int32 BigInteger::GetSign()
+bool BigInteger::ToInt64(int64 &ret) const
+{
+	if (this->_bits == nullptr)
+	{
+		ret = this->_sign;
+		return true;
+	}
+
+	int32 length = Length(this->_bits, this->_bitsSize);
+
+	if (length > 2)
+	{
+		// more than 64 bits
+		return false;
+	}
+
+	uint64 magnitude = length > 1 ? (((uint64)this->_bits[1] << 32) | this->_bits[0]) : this->_bits[0];
+
+	if (this->_sign > 0)
+	{
+		if (magnitude > 0x7FFFFFFFFFFFFFFFULL)
+		{
+			return false;
+		}
+
+		ret = (int64)magnitude;
+		return true;
+	}
+
+	if (magnitude > 0x8000000000000000ULL)
+	{
+		// value < Int64.MinValue
+		return false;
+	}
+
+	ret = (int64)(0 - magnitude);
+	return true;
+}
+
+int32 BigInteger::GetSign() const
 {
 	return (this->_sign >> (BigInteger::kcbitUint - 1)) - (-this->_sign >> (BigInteger::kcbitUint - 1));
 }
 
-int32 BigInteger::ToByteArraySize()
+int32 BigInteger::GetBitLength() const
+{
+	uint32 high;
+	int32 length;
+
+	if (this->_bits == nullptr)
+	{
+		high = this->_sign < 0 ? (uint32)-this->_sign : (uint32)this->_sign;
+		length = 0;
+	}
+	else
+	{
+		int32 cu = Length(this->_bits, this->_bitsSize);
+
+		high = this->_bits[cu - 1];
+		length = (cu - 1) * kcbitUint;
+	}
+
+	for (; high != 0; high >>= 1)
+		++length;
+
+	return length;
+}
+
+int32 BigInteger::ToByteArraySize() const
 {
 	if (_cachedSize != -1)
 	{
@@ -1083,10 +1224,13 @@ int32 BigInteger::ToByteArraySize()
 	int32 dwordsSize;
 	byte highByte;
 	uint32* dwords;
+	uint32 smallDword;
+	ScratchBits clone(this->_bitsSize);
 
 	if (this->_bitsSize == 0)
 	{
-		dwords = new uint32[1]{ (uint32)_sign };
+		smallDword = (uint32)_sign;
+		dwords = &smallDword;
 		dwordsSize = 1;
 		highByte = (byte)((_sign < 0) ? 0xff : 0x00);
 	}
@@ -1097,7 +1241,7 @@ int32 BigInteger::ToByteArraySize()
 		if (this->_bits != nullptr)
 		{
 			// Clone
-			dwords = new uint32[dwordsSize];
+			dwords = clone;
 			for (int32 x = 0; x < dwordsSize; ++x)
 				dwords[x] = this->_bits[x];
 
@@ -1118,7 +1262,7 @@ int32 BigInteger::ToByteArraySize()
 		highByte = 0x00;
 	}
 
-	byte* bytes = new byte[4 * dwordsSize]/*()*/;
+	ScratchBytes bytes(4 * dwordsSize);
 	int32 curByte = 0;
 
 	uint32 dword;
@@ -1144,16 +1288,10 @@ int32 BigInteger::ToByteArraySize()
 
 	_cachedSize = msb + 1 + (needExtraByte ? 1 : 0);
 
-	// Free memory
-
-	delete[] bytes;
-	if (dwords != this->_bits)
-		delete[]dwords;
-
 	return _cachedSize;
 }
 
-int32 BigInteger::ToByteArray(byte* output, int32 length)
+int32 BigInteger::ToByteArray(byte* output, int32 length) const
 {
 	if (this->_bitsSize == 0 && _sign == 0)
 	{
@@ -1173,10 +1311,13 @@ int32 BigInteger::ToByteArray(byte* output, int32 length)
 	int32 dwordsSize;
 	byte highByte;
 	uint32* dwords;
+	uint32 smallDword;
+	ScratchBits clone(this->_bitsSize);
 
 	if (this->_bitsSize == 0)
 	{
-		dwords = new uint32[1]{ (uint32)_sign };
+		smallDword = (uint32)_sign;
+		dwords = &smallDword;
 		dwordsSize = 1;
 		highByte = (byte)((_sign < 0) ? 0xff : 0x00);
 	}
@@ -1187,7 +1328,7 @@ int32 BigInteger::ToByteArray(byte* output, int32 length)
 		if (this->_bits != nullptr)
 		{
 			// Clone
-			dwords = new uint32[dwordsSize];
+			dwords = clone;
 			for (int32 x = 0; x < dwordsSize; ++x)
 				dwords[x] = this->_bits[x];
 
@@ -1208,7 +1349,7 @@ int32 BigInteger::ToByteArray(byte* output, int32 length)
 		highByte = 0x00;
 	}
 
-	byte* bytes = new byte[4 * dwordsSize]/*()*/;
+	ScratchBytes bytes(4 * dwordsSize);
 	int32 curByte = 0;
 
 	uint32 dword;
@@ -1243,20 +1384,10 @@ int32 BigInteger::ToByteArray(byte* output, int32 length)
 	{
 		l = 0;
 	}
-	// Free memory
-
-	delete[] bytes;
-	if (dwords != this->_bits)
-		delete[]dwords;
-
 	return l;
 }
 
 BigInteger::~BigInteger()
 {
-	if (this->_bits == nullptr) return;
-
-	delete[]this->_bits;
-	this->_bits = nullptr;
-	this->_bitsSize = 0;
+	this->FreeBits();
 }
\ No newline at end of file
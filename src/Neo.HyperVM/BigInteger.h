@@ -15,7 +15,9 @@ public:
 	const static BigInteger Zero;
 	const static BigInteger MinusOne;
 
+	BigInteger();
 	BigInteger(int32 value);
+	BigInteger(int64 value);
 	BigInteger(const BigInteger &value);
 	BigInteger(BigInteger* value);
 	BigInteger(uint32 value);
@@ -23,13 +25,15 @@ public:
 	BigInteger(uint32* value, int32 size, bool negative);
 	BigInteger(byte* value, int32 byteCount);
 
-	BigInteger* Clone();
+	BigInteger& operator=(const BigInteger &value);
+
 	void CopyInternal(const BigInteger &ret);
 
-	bool ToInt32(int32 &ret);
-	int32 ToByteArraySize();
+	bool ToInt32(int32 &ret) const;
+	bool ToInt64(int64 &ret) const;
+	int32 ToByteArraySize() const;
 
-	inline bool SizeExceeded()
+	inline bool SizeExceeded() const
 	{
 		// Check fast size
 
@@ -48,25 +52,48 @@ public:
 		return this->ToByteArraySize() > MAX_BIGINTEGER_SIZE;
 	}
 
-	int32 ToByteArray(byte* output, int32 length);
-
-	BigInteger* Div(BigInteger* reg);
-	BigInteger* Mul(BigInteger* reg);
-	BigInteger* Mod(BigInteger* reg);
-	BigInteger* Add(BigInteger* reg);
-	BigInteger* Sub(BigInteger* reg);
-	BigInteger* And(BigInteger* reg);
-	BigInteger* Or(BigInteger* reg);
-	BigInteger* Xor(BigInteger* reg);
-	BigInteger* Invert();
-	BigInteger* Negate();
-	BigInteger* Abs();
-	BigInteger* Shl(int32 shift);
-	BigInteger* Shr(int32 shift);
-	int32 GetSign();
-
-	int32 CompareTo(BigInteger* bi);
-	int32 CompareTo(const BigInteger &bi);
+	int32 ToByteArray(byte* output, int32 length) const;
+
+	// Heap bytes used by the limbs, zero when they are stored inline
+
+	inline int32 GetAllocatedSize() const
+	{
+		if (this->_bits == nullptr || this->_bits == this->_inlineBits)
+		{
+			return 0;
+		}
+
+		return this->_bitsSize * static_cast<int32>(sizeof(uint32));
+	}
+
+	// Operations, the result is written to ret (that can be one of the operands).
+	// Div and Mod return false on division by zero
+
+	bool Div(const BigInteger &reg, BigInteger &ret) const;
+	void Mul(const BigInteger &reg, BigInteger &ret) const;
+	bool Mod(const BigInteger &reg, BigInteger &ret) const;
+	void Add(const BigInteger &reg, BigInteger &ret) const;
+	void Sub(const BigInteger &reg, BigInteger &ret) const;
+	void And(const BigInteger &reg, BigInteger &ret) const;
+	void Or(const BigInteger &reg, BigInteger &ret) const;
+	void Xor(const BigInteger &reg, BigInteger &ret) const;
+	void Invert(BigInteger &ret) const;
+	void Negate(BigInteger &ret) const;
+	void Abs(BigInteger &ret) const;
+	void Shl(int32 shift, BigInteger &ret) const;
+	void Shr(int32 shift, BigInteger &ret) const;
+	int32 GetSign() const;
+
+	// Bits of the magnitude, zero for zero
+
+	int32 GetBitLength() const;
+
+	int32 CompareTo(const BigInteger &bi) const;
+
+	// Order of two little endian two's complement encodings, without decoding them
+	// (any length, the sign extension bytes are ignored)
+
+	static int32 CompareEncoding(const byte* x, int32 xl, const byte* y, int32 yl);
 
 	~BigInteger();
 
@@ -79,16 +106,44 @@ private:
 	const static uint32 kuMaskHighBit = Int32MinValue;
 	const static int32 kcbitUint = 32;
 
+	// Limbs of the biggest legal value. The operations work in scratch buffers, and a wider result
+	// (that SizeExceeded rejects) is stored on the heap
+
+	const static int32 InlineBitsLength = MAX_BIGINTEGER_SIZE / 4 + 1;
+
 	int32 _sign;
 	uint32* _bits;
 	int32 _bitsSize;
-	int32 _cachedSize;
+	mutable int32 _cachedSize;
+	uint32 _inlineBits[InlineBitsLength];
+
+	inline void SetBits(const uint32* value, int32 size)
+	{
+		this->_bits = size <= InlineBitsLength ? this->_inlineBits : new uint32[size];
+		this->_bitsSize = size;
+
+		for (int32 x = 0; x < size; ++x)
+			this->_bits[x] = value[x];
+	}
+
+	inline void FreeBits()
+	{
+		if (this->_bits != nullptr && this->_bits != this->_inlineBits)
+		{
+			delete[](this->_bits);
+		}
+
+		this->_bits = nullptr;
+		this->_bitsSize = 0;
+	}
 
-	static bool GetPartsForBitManipulation(BigInteger* x, uint32* &xd, int32 &xl);
+	static bool GetPartsForBitManipulation(const BigInteger* x, uint32* xd, int32 &xl);
 	static void DangerousMakeTwosComplement(uint32* d, int32 dSize);
-	static int32 Length(uint32* rgu, int32 size);
-	static int32 GetDiffLength(uint32* rgu1, uint32* rgu2, int32 cu);
+	static int32 Length(const uint32* rgu, int32 size);
+	static int32 GetDiffLength(const uint32* rgu1, const uint32* rgu2, int32 cu);
 
-	int32 ToUInt32Array(uint32* &output);
-	BigInteger(int32 sign, uint32* rgu, int32 rguSize);
+	int32 ToUInt32Array(uint32* output) const;
+	int32 GetMagnitude(uint32 &small, const uint32* &bits) const;
+	void AddSigned(const BigInteger &bi, int32 biSign, BigInteger &ret) const;
+	BigInteger(int32 sign, const uint32* rgu, int32 rguSize);
 };
\ No newline at end of file
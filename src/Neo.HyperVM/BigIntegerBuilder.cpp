@@ -11,10 +11,12 @@ BigIntegerBuilder::BigIntegerBuilder()
 	// AssertValid(true);
 }
 
-BigIntegerBuilder::BigIntegerBuilder(int32 sign, uint32* bits, int32 bitSize, int32 &outSign)
+BigIntegerBuilder::BigIntegerBuilder(int32 sign, const uint32* bits, int32 bitSize, int32 &outSign)
 {
+	// The operand is only read, a writable copy is made before any change
+
 	this->_fWritable = false;
-	this->_rgu = bits;
+	this->_rgu = const_cast<uint32*>(bits);
 	this->_rguLength = bitSize;
 
 	int32 n = sign;
@@ -47,6 +49,8 @@ void BigIntegerBuilder::GetInteger(int32 &sign, uint32* &bits, int32 &bitSize)
 	// Contract.Requires(signSrc == +1 || signSrc == -1);
 	// AssertValid(true);
 
+	// The result is copied by the BigInteger, the buffers stay owned by the builder
+
 	if (this->_iuLast == 0)
 	{
 		if (this->_uSmall <= Int32MaxValue)
@@ -57,58 +61,13 @@ void BigIntegerBuilder::GetInteger(int32 &sign, uint32* &bits, int32 &bitSize)
 			return;
 		}
 
-		if (this->_rgu == nullptr)
-		{
-			this->_rgu = new uint32[1]{ this->_uSmall };
-			this->_rguLength = 1;
-		}
-		else if (this->_fWritable)
-		{
-			this->_rgu[0] = this->_uSmall;
-		}
-		else if (this->_rgu[0] != this->_uSmall)
-		{
-			this->_rgu = new uint32[1]{ this->_uSmall };
-		}
-	}
-
-	// The sign is +/- 1.
-	// sign = signSrc;
-
-	int32 cuExtra = this->_rguLength - this->_iuLast - 1;
-	// Contract.Assert(cuExtra >= 0);
-
-	if (cuExtra <= 1)
-	{
-		if (cuExtra == 0 || this->_rgu[this->_iuLast + 1] == 0)
-		{
-			this->_fWritable = false;
-			bits = this->_rgu;
-			bitSize = this->_rguLength;
-			return;
-		}
-		if (this->_fWritable)
-		{
-			this->_rgu[this->_iuLast + 1] = 0;
-			this->_fWritable = false;
-			bits = this->_rgu;
-			bitSize = this->_rguLength;
-			return;
-		}
-		// The buffer isn't writable, but has an extra uint that is non-zero,
-		// so we have to allocate a new buffer.
+		bits = &this->_uSmall;
+		bitSize = 1;
+		return;
 	}
 
-	// Keep the bigger buffer (if it is writable), but create a smaller one for the BigInteger.
-
 	bits = this->_rgu;
 	bitSize = this->_iuLast + 1;
-	// Array.Resize(ref bits, _iuLast + 1);
-
-	if (!this->_fWritable)
-	{
-		this->_rgu = bits;
-	}
 }
 
 void BigIntegerBuilder::Div(BigIntegerBuilder &regDen)
@@ -127,18 +86,20 @@ void BigIntegerBuilder::Div(BigIntegerBuilder &regDen)
 		return;
 	}
 
-	BigIntegerBuilder regTmp = BigIntegerBuilder();
+	BigIntegerBuilder regTmp;
 	ModDivCore(this, regDen, true, regTmp);
 
-	// Swap(this, regTmp);
-
-	if (this->_fWritable && this->_rgu != nullptr)
+	if (regTmp._rgu == regTmp._scratch)
 	{
-		// Clean
-		delete[](this->_rgu);
+		// Can't take the working space of the other register
+
+		this->Load(regTmp, 0);
+		return;
 	}
 
-	// Swap
+	// Swap(this, regTmp);
+
+	this->Release();
 
 	this->_fWritable = regTmp._fWritable;
 	this->_rguLength = regTmp._rguLength;
@@ -186,7 +147,7 @@ void BigIntegerBuilder::Mod(BigIntegerBuilder &regDen)
 	if (this->_iuLast == 0)
 		return;
 
-	BigIntegerBuilder regTmp = BigIntegerBuilder();
+	BigIntegerBuilder regTmp;
 	ModDivCore(this, regDen, false, regTmp);
 }
 
@@ -271,7 +232,7 @@ void BigIntegerBuilder::EnsureWritable(int32 cu, int32 cuExtra)
 	if (this->_fWritable && this->_rguLength >= cu)
 		return;
 
-	uint32* rgu = new uint32[cu + cuExtra];
+	uint32* rgu = this->Allocate(cu + cuExtra);
 
 	if (this->_iuLast > 0)
 	{
@@ -283,6 +244,8 @@ void BigIntegerBuilder::EnsureWritable(int32 cu, int32 cuExtra)
 			rgu[x] = this->_rgu[x];
 	}
 
+	this->Release();
+
 	this->_rguLength = cu + cuExtra;
 	this->_rgu = rgu;
 	this->_fWritable = true;
@@ -304,11 +267,15 @@ void BigIntegerBuilder::EnsureWritable(int32 cuExtra)
 	}
 
 	int32 l = _iuLast + 1 + cuExtra;
-	uint32* rgu = new uint32[l];
+	uint32* rgu = this->Allocate(l);
 
-	for (int32 x = l - 1; x >= 0; x--)
+	// Array.Copy(_rgu, rgu, _iuLast + 1);
+	for (int32 x = this->_iuLast; x >= 0; x--)
 		rgu[x] = this->_rgu[x];
 
+	for (int32 x = this->_iuLast + 1; x < l; x++)
+		rgu[x] = 0;
+
 	this->_rgu = rgu;
 	this->_rguLength = _iuLast + 1 + cuExtra;
 	this->_fWritable = true;
@@ -330,11 +297,11 @@ void BigIntegerBuilder::SetSizeLazy(int32 cu)
 	}
 	if (!this->_fWritable || this->_rguLength < cu)
 	{
-		if (this->_fWritable && this->_rgu != nullptr)
-			delete[](this->_rgu);
+		uint32* rgu = this->Allocate(cu);
+		this->Release();
 
 		this->_rguLength = cu;
-		this->_rgu = new uint32[cu];
+		this->_rgu = rgu;
 		this->_fWritable = true;
 	}
 
@@ -588,12 +555,13 @@ void BigIntegerBuilder::ApplyCarry(int32 iu)
 			if (this->_iuLast + 1 == this->_rguLength)
 			{
 				//Array.Resize(ref _rgu, _iuLast + 2);
-				uint32* nrgu = new uint32[_iuLast + 2];
-				for (int32 x = _iuLast + 1; x >= 0; x--)
+				uint32* nrgu = this->Allocate(_iuLast + 2);
+				for (int32 x = _iuLast; x >= 0; x--)
 					nrgu[x] = this->_rgu[x];
 
-				// TODO: Check this!
+				this->Release();
 				this->_rgu = nrgu;
+				this->_rguLength = _iuLast + 2;
 			}
 			this->_rgu[++this->_iuLast] = 1;
 			break;
@@ -647,7 +615,7 @@ void BigIntegerBuilder::SetSizeKeep(int32 cu, int32 cuExtra)
 	if (!this->_fWritable || this->_rguLength < cu)
 	{
 		int32 l = cu + cuExtra;
-		uint32* rgu = new uint32[l];
+		uint32* rgu = this->Allocate(l);
 		if (this->_iuLast == 0)
 		{
 			rgu[0] = this->_uSmall;
@@ -668,8 +636,7 @@ void BigIntegerBuilder::SetSizeKeep(int32 cu, int32 cuExtra)
 				rgu[i] = 0;
 		}
 
-		if (this->_fWritable && this->_rgu != nullptr)
-			delete[](this->_rgu);
+		this->Release();
 
 		this->_rguLength = l;
 		this->_rgu = rgu;
@@ -706,13 +673,10 @@ void BigIntegerBuilder::Load(BigIntegerBuilder &reg, int32 cuExtra)
 	{
 		if (!this->_fWritable || this->_rguLength <= reg._iuLast)
 		{
-			if (this->_fWritable && this->_rgu != nullptr)
-			{
-				// Free
-				delete[](this->_rgu);
-			}
+			uint32* rgu = this->Allocate(reg._iuLast + 1 + cuExtra);
+			this->Release();
 
-			this->_rgu = new uint32[reg._iuLast + 1 + cuExtra];
+			this->_rgu = rgu;
 			this->_rguLength = reg._iuLast + 1 + cuExtra;
 			this->_fWritable = true;
 		}
@@ -1046,8 +1010,6 @@ void BigIntegerBuilder::Sub(int32 &sign, BigIntegerBuilder &reg)
 
 BigIntegerBuilder::~BigIntegerBuilder()
 {
-	if (this->_rgu == nullptr || !this->_fWritable) return;
-
-	delete[](this->_rgu);
+	this->Release();
 	this->_rgu = nullptr;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Types.h"
+#include "Limits.h"
 
 class BigIntegerBuilder
 {
@@ -23,6 +24,30 @@ private:
 
 	int32 _rguLength;
 
+	// Working space for the legal values (a MUL of two legal operands plus a carry),
+	// bigger registers are allocated
+
+	static const int32 ScratchLength = 2 * (MAX_BIGINTEGER_SIZE / 4) + 2;
+	uint32 _scratch[ScratchLength];
+
+	inline uint32* Allocate(int32 cu)
+	{
+		if (cu <= ScratchLength && this->_rgu != this->_scratch)
+		{
+			return this->_scratch;
+		}
+
+		return new uint32[cu];
+	}
+
+	inline void Release()
+	{
+		if (this->_fWritable && this->_rgu != nullptr && this->_rgu != this->_scratch)
+		{
+			delete[](this->_rgu);
+		}
+	}
+
 	static int32 CbitHighZero(uint32 u);
 	static int32 CbitHighZero(uint64 uu);
 	static uint32 AddCarry(uint32 &u1, uint32 u2, uint32 uCarry);
@@ -66,7 +91,7 @@ public:
 
 	// Constructor
 
-	BigIntegerBuilder(int32 sign, uint32* bits, int32 bitSize, int32 &outSign);
+	BigIntegerBuilder(int32 sign, const uint32* bits, int32 bitSize, int32 &outSign);
 
 	// Destructor
 
@@ -0,0 +1,295 @@
+#include "BigIntegerKernel.h"
+
+#ifdef BIGINTEGER_KERNEL64
+
+#include "Limits.h"
+#include "ScratchBuffer.h"
+
+// 64 bits limbs of a product of two legal values, plus the normalization limb
+
+const int32 ScratchLimbs64 = 2 * (MAX_BIGINTEGER_SIZE / 8) + 2;
+
+typedef ScratchBuffer<uint64, ScratchLimbs64> ScratchLimbs;
+
+int32 BigIntegerKernel::Trim(const uint64* x, int32 xl)
+{
+	while (xl > 0 && x[xl - 1] == 0) --xl;
+
+	return xl;
+}
+
+int32 BigIntegerKernel::Load(const uint32* x, int32 xl, uint64* ret)
+{
+	int32 l = (xl + 1) / 2;
+
+	for (int32 i = 0; i < xl / 2; ++i)
+		ret[i] = (uint64)x[2 * i] | ((uint64)x[2 * i + 1] << 32);
+
+	if ((xl & 1) != 0)
+		ret[l - 1] = x[xl - 1];
+
+	return Trim(ret, l);
+}
+
+int32 BigIntegerKernel::Store(const uint64* x, int32 xl, uint32* ret)
+{
+	xl = Trim(x, xl);
+
+	if (xl == 0)
+	{
+		return 0;
+	}
+
+	int32 l = 0;
+
+	for (int32 i = 0; i < xl - 1; ++i)
+	{
+		ret[l++] = (uint32)x[i];
+		ret[l++] = (uint32)(x[i] >> 32);
+	}
+
+	uint64 high = x[xl - 1];
+	ret[l++] = (uint32)high;
+
+	if ((high >> 32) != 0)
+		ret[l++] = (uint32)(high >> 32);
+
+	return l;
+}
+
+int32 BigIntegerKernel::Compare(const uint32* x, int32 xl, const uint32* y, int32 yl)
+{
+	while (xl > 0 && x[xl - 1] == 0) --xl;
+	while (yl > 0 && y[yl - 1] == 0) --yl;
+
+	if (xl != yl)
+		return xl < yl ? -1 : +1;
+
+	for (int32 i = xl - 1; i >= 0; --i)
+	{
+		if (x[i] != y[i])
+			return x[i] < y[i] ? -1 : +1;
+	}
+
+	return 0;
+}
+
+int32 BigIntegerKernel::Add(const uint32* x, int32 xl, const uint32* y, int32 yl, uint32* z)
+{
+	ScratchLimbs xd((xl + 1) / 2), yd((yl + 1) / 2);
+
+	uint64* a = xd;
+	uint64* b = yd;
+	int32 al = Load(x, xl, a);
+	int32 bl = Load(y, yl, b);
+
+	if (al < bl)
+	{
+		uint64* t = a; a = b; b = t;
+		int32 tl = al; al = bl; bl = tl;
+	}
+
+	ScratchLimbs c(al + 1);
+	uint64 carry = 0;
+
+	for (int32 i = 0; i < bl; ++i)
+	{
+		uint128 t = (uint128)a[i] + b[i] + carry;
+		c[i] = (uint64)t;
+		carry = (uint64)(t >> 64);
+	}
+
+	for (int32 i = bl; i < al; ++i)
+	{
+		uint128 t = (uint128)a[i] + carry;
+		c[i] = (uint64)t;
+		carry = (uint64)(t >> 64);
+	}
+
+	c[al] = carry;
+
+	return Store(c, al + 1, z);
+}
+
+int32 BigIntegerKernel::Sub(const uint32* x, int32 xl, const uint32* y, int32 yl, uint32* z)
+{
+	// x >= y
+
+	ScratchLimbs a((xl + 1) / 2), b((yl + 1) / 2);
+
+	int32 al = Load(x, xl, a);
+	int32 bl = Load(y, yl, b);
+
+	ScratchLimbs c(al);
+	uint64 borrow = 0;
+
+	for (int32 i = 0; i < bl; ++i)
+	{
+		uint128 t = (uint128)a[i] - b[i] - borrow;
+		c[i] = (uint64)t;
+		borrow = (uint64)(t >> 64) & 1;
+	}
+
+	for (int32 i = bl; i < al; ++i)
+	{
+		uint128 t = (uint128)a[i] - borrow;
+		c[i] = (uint64)t;
+		borrow = (uint64)(t >> 64) & 1;
+	}
+
+	return Store(c, al, z);
+}
+
+int32 BigIntegerKernel::Mul(const uint32* x, int32 xl, const uint32* y, int32 yl, uint32* z)
+{
+	ScratchLimbs a((xl + 1) / 2), b((yl + 1) / 2);
+
+	int32 al = Load(x, xl, a);
+	int32 bl = Load(y, yl, b);
+
+	if (al == 0 || bl == 0)
+	{
+		return 0;
+	}
+
+	ScratchLimbs c(al + bl);
+
+	for (int32 i = 0; i < al + bl; ++i)
+		c[i] = 0;
+
+	for (int32 i = 0; i < al; ++i)
+	{
+		uint64 carry = 0;
+
+		for (int32 j = 0; j < bl; ++j)
+		{
+			// Can't overflow: (2^64 - 1)^2 + 2 * (2^64 - 1) = 2^128 - 1
+
+			uint128 t = (uint128)a[i] * b[j] + c[i + j] + carry;
+			c[i + j] = (uint64)t;
+			carry = (uint64)(t >> 64);
+		}
+
+		c[i + bl] = carry;
+	}
+
+	return Store(c, al + bl, z);
+}
+
+void BigIntegerKernel::DivRem(const uint32* x, int32 xl, const uint32* y, int32 yl, uint32* q, int32 &ql, uint32* r, int32 &rl)
+{
+	// y != 0
+
+	ScratchLimbs u((xl + 1) / 2), v((yl + 1) / 2);
+
+	int32 ul = Load(x, xl, u);
+	int32 vl = Load(y, yl, v);
+
+	if (ul < vl)
+	{
+		ql = 0;
+		rl = Store(u, ul, r);
+		return;
+	}
+
+	ScratchLimbs qd(ul - vl + 1);
+
+	if (vl == 1)
+	{
+		// Short division
+
+		uint64 d = v[0];
+		uint64 rem = 0;
+
+		for (int32 i = ul - 1; i >= 0; --i)
+		{
+			uint128 num = ((uint128)rem << 64) | u[i];
+			qd[i] = (uint64)(num / d);
+			rem = (uint64)(num % d);
+		}
+
+		ql = Store(qd, ul, q);
+		rl = Store(&rem, 1, r);
+		return;
+	}
+
+	// Knuth's algorithm D, normalized so the high bit of the divisor is set
+
+	int32 s = __builtin_clzll(v[vl - 1]);
+
+	ScratchLimbs vn(vl), un(ul + 1);
+
+	for (int32 i = vl - 1; i > 0; --i)
+		vn[i] = (v[i] << s) | (s == 0 ? 0 : v[i - 1] >> (64 - s));
+	vn[0] = v[0] << s;
+
+	un[ul] = s == 0 ? 0 : u[ul - 1] >> (64 - s);
+	for (int32 i = ul - 1; i > 0; --i)
+		un[i] = (u[i] << s) | (s == 0 ? 0 : u[i - 1] >> (64 - s));
+	un[0] = u[0] << s;
+
+	for (int32 j = ul - vl; j >= 0; --j)
+	{
+		// Estimate the quotient digit, it can be one too big after the correction
+
+		uint128 num = ((uint128)un[j + vl] << 64) | un[j + vl - 1];
+		uint128 qhat = num / vn[vl - 1];
+		uint128 rhat = num % vn[vl - 1];
+
+		while ((qhat >> 64) != 0 || qhat * vn[vl - 2] > ((rhat << 64) | un[j + vl - 2]))
+		{
+			--qhat;
+			rhat += vn[vl - 1];
+
+			if ((rhat >> 64) != 0) break;
+		}
+
+		// Multiply and subtract
+
+		uint64 borrow = 0;
+		uint64 carry = 0;
+
+		for (int32 i = 0; i < vl; ++i)
+		{
+			uint128 p = qhat * vn[i] + carry;
+			carry = (uint64)(p >> 64);
+
+			uint128 t = (uint128)un[i + j] - (uint64)p - borrow;
+			un[i + j] = (uint64)t;
+			borrow = (uint64)(t >> 64) & 1;
+		}
+
+		uint128 t = (uint128)un[j + vl] - carry - borrow;
+		un[j + vl] = (uint64)t;
+		qd[j] = (uint64)qhat;
+
+		if (((uint64)(t >> 64) & 1) != 0)
+		{
+			// Subtracted too much, add back
+
+			--qd[j];
+			carry = 0;
+
+			for (int32 i = 0; i < vl; ++i)
+			{
+				uint128 a = (uint128)un[i + j] + vn[i] + carry;
+				un[i + j] = (uint64)a;
+				carry = (uint64)(a >> 64);
+			}
+
+			un[j + vl] += carry;
+		}
+	}
+
+	ql = Store(qd, ul - vl + 1, q);
+
+	// Unnormalize the remainder
+
+	for (int32 i = 0; i < vl - 1; ++i)
+		un[i] = (un[i] >> s) | (s == 0 ? 0 : un[i + 1] << (64 - s));
+	un[vl - 1] >>= s;
+
+	rl = Store(un, vl, r);
+}
+
+#endif
\ No newline at end of file
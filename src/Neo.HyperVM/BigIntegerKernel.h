@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Types.h"
+
+// The magnitudes are added, multiplied and divided with 64 bits limbs when the compiler
+// has 128 bits integers, otherwise BigIntegerBuilder is used (define BIGINTEGER_KERNEL32 to force it)
+
+#if defined(__SIZEOF_INT128__) && !defined(BIGINTEGER_KERNEL32)
+#define BIGINTEGER_KERNEL64
+#endif
+
+#ifdef BIGINTEGER_KERNEL64
+
+// Magnitudes are the little endian uint32 limbs of BigInteger, the results are trimmed
+// and the outputs must have room for the biggest one: max(xl, yl) + 1 limbs for Add,
+// xl for Sub, xl + yl for Mul, xl for the quotient and yl for the remainder
+
+class BigIntegerKernel
+{
+private:
+
+	typedef unsigned __int128 uint128;
+
+	static int32 Load(const uint32* x, int32 xl, uint64* ret);
+	static int32 Store(const uint64* x, int32 xl, uint32* ret);
+	static int32 Trim(const uint64* x, int32 xl);
+
+public:
+
+	static int32 Compare(const uint32* x, int32 xl, const uint32* y, int32 yl);
+	static int32 Add(const uint32* x, int32 xl, const uint32* y, int32 yl, uint32* z);
+	static int32 Sub(const uint32* x, int32 xl, const uint32* y, int32 yl, uint32* z);
+	static int32 Mul(const uint32* x, int32 xl, const uint32* y, int32 yl, uint32* z);
+	static void DivRem(const uint32* x, int32 xl, const uint32* y, int32 yl, uint32* q, int32 &ql, uint32* r, int32 &rl);
+};
+
+#endif
\ No newline at end of file
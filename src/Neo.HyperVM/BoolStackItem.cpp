@@ -39,29 +39,4 @@ bool BoolStackItem::Equals(IStackItem* it)
 		}
 	}
 	}
-}
-
-int32 BoolStackItem::ReadByteArray(byte* output, int32 sourceIndex, int32 count)
-{
-	if (sourceIndex != 0)
-	{
-		return -1;
-	}
-
-	if (count < 0)
-	{
-		return 0;
-	}
-
-	if (this->_value)
-	{
-		if (count == 0) return 0;
-
-		output[0] = 0x01;
-		return 1;
-	}
-	else
-	{
-		return 0;
-	}
 }
\ No newline at end of file
@@ -1,7 +1,8 @@
 #pragma once
 #include "IStackItem.h"
+#include "StackItemHelper.h"
 
-class BoolStackItem : public IStackItem
+class BoolStackItem final : public IStackItem
 {
 private:
 
@@ -16,9 +17,9 @@ public:
 		return this->_value;
 	}
 
-	inline BigInteger* GetBigInteger()
+	inline const BigInteger* GetBigInteger(BigInteger &temp)
 	{
-		return new BigInteger(this->_value ? BigInteger::One : BigInteger::Zero);
+		return this->_value ? &BigInteger::One : &BigInteger::Zero;
 	}
 
 	inline bool GetInt32(int32 &ret)
@@ -27,25 +28,66 @@ public:
 		return true;
 	}
 
-	int32 ReadByteArray(byte* output, int32 sourceIndex, int32 count);
+	inline bool GetInt64(int64 &ret)
+	{
+		ret = this->_value ? 1 : 0;
+		return true;
+	}
+
+	inline int32 ReadByteArray(byte* output, int32 sourceIndex, int32 count)
+	{
+		if (sourceIndex != 0)
+		{
+			return -1;
+		}
+
+		if (!this->_value || count <= 0)
+		{
+			return 0;
+		}
+
+		output[0] = 0x01;
+		return 1;
+	}
 
 	inline int32 ReadByteArraySize()
 	{
 		return this->_value ? 1 : 0;
 	}
 
+	inline int32 GetByteArrayView(const byte* &data)
+	{
+		static const byte trueValue = 0x01;
+
+		data = &trueValue;
+		return this->_value ? 1 : 0;
+	}
+
 	bool Equals(IStackItem* it);
 
+	// Hash
+
+	inline uint32 GetHash()
+	{
+		// Same hash as the equivalent byte array (false = empty, true = 0x01)
+
+		byte data = 0x01;
+		return StackItemHelper::Hash(&data, this->_value ? 1 : 0);
+	}
+
 	// Constructor & Destructor
 
 	inline BoolStackItem(IStackItemCounter* counter, bool value) :
 		IStackItem(counter, EStackItemType::Bool), 
 		_value(value) 
 	{
-
+		counter->MemoryInc(sizeof(BoolStackItem));
 	}
 
-	inline ~BoolStackItem() { }
+	inline ~BoolStackItem()
+	{
+		this->GetCounter()->MemoryDec(sizeof(BoolStackItem));
+	}
 
 	// Serialize
 
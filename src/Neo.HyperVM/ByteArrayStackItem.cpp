@@ -3,7 +3,9 @@
 
 ByteArrayStackItem::ByteArrayStackItem(IStackItemCounter* counter, byte* data, int32 size, bool copyPointer) :
 	IStackItem(counter, EStackItemType::ByteArray),
-	_payloadLength(size)
+	_payloadLength(size),
+	_hash(0),
+	_integer(nullptr)
 {
 	if (size > 0 && data != nullptr)
 	{
@@ -16,30 +18,16 @@ ByteArrayStackItem::ByteArrayStackItem(IStackItemCounter* counter, byte* data, i
 			this->_payload = new byte[size];
 			memcpy(this->_payload, data, size);
 		}
+
+		counter->MemoryInc(sizeof(ByteArrayStackItem) + size);
 	}
 	else
 	{
 		this->_payload = nullptr;
+		counter->MemoryInc(sizeof(ByteArrayStackItem));
 	}
 }
 
-int32 ByteArrayStackItem::ReadByteArray(byte* output, int32 sourceIndex, int32 count)
-{
-	if (sourceIndex < 0)
-	{
-		return -1;
-	}
-
-	int32 l = count > this->_payloadLength - sourceIndex ? this->_payloadLength - sourceIndex : count;
-
-	if (l > 0)
-	{
-		memcpy(output, &this->_payload[sourceIndex], l);
-	}
-
-	return l;
-}
-
 bool ByteArrayStackItem::Equals(IStackItem* it)
 {
 	if (it == this) return true;
@@ -51,40 +39,17 @@ bool ByteArrayStackItem::Equals(IStackItem* it)
 		auto t = (ByteArrayStackItem*)it;
 		if (t->_payloadLength != this->_payloadLength) return false;
 
-		for (int32 x = t->_payloadLength - 1; x >= 0; x--)
-			if (t->_payload[x] != this->_payload[x])
-				return false;
-
-		return true;
+		return ByteKernel::Equals(t->_payload, this->_payload, this->_payloadLength);
 	}
 	default:
 	{
-		int32 iz = it->ReadByteArraySize();
-
-		if (iz < 0)
-			return false;
-
-		if (iz == 0)
-			return this->_payloadLength == 0;
-
-		byte* data = new byte[iz];
-		iz = it->ReadByteArray(data, 0, iz);
+		const byte* data;
+		int32 iz = it->GetByteArrayView(data);
 
 		if (iz != this->_payloadLength)
-		{
-			delete[](data);
 			return false;
-		}
-
-		for (int32 x = 0; x < iz; ++x)
-			if (data[x] != this->_payload[x])
-			{
-				delete[](data);
-				return false;
-			}
 
-		delete[](data);
-		return true;
+		return ByteKernel::Equals(data, this->_payload, iz);
 	}
 	}
 }
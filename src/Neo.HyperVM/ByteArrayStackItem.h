@@ -1,34 +1,60 @@
 #pragma once
 #include "IStackItem.h"
+#include "StackItemHelper.h"
+#include "ByteKernel.h"
+#include <string.h>
 
-class ByteArrayStackItem : public IStackItem
+class ByteArrayStackItem final : public IStackItem
 {
 private:
 
 	int32 _payloadLength;
+
+	// Hash of the payload, 0 until it's computed (in the padding before the pointer)
+
+	uint32 _hash;
 	byte* _payload;
 
+	// Integer value, decoded on the first use (the payload is immutable) and counted as memory of the item
+
+	BigInteger* _integer;
+
+	inline BigInteger* GetCachedInteger()
+	{
+		if (this->_integer == nullptr)
+		{
+			this->_integer = new BigInteger(this->_payload, this->_payloadLength);
+			this->GetCounter()->MemoryInc(sizeof(BigInteger) + this->_integer->GetAllocatedSize());
+		}
+
+		return this->_integer;
+	}
+
 public:
 
 	// Converters
 
 	inline bool GetBoolean()
 	{
-		for (int32 x = 0; x < this->_payloadLength; ++x)
-			if (this->_payload[x] != 0x00)
-				return true;
-
-		return false;
+		return !ByteKernel::IsZero(this->_payload, this->_payloadLength);
 	}
 
-	inline BigInteger* GetBigInteger()
+	inline const BigInteger* GetBigInteger(BigInteger &temp)
 	{
 		if (this->_payloadLength == 0)
 		{
-			return new BigInteger(BigInteger::Zero);
+			return &BigInteger::Zero;
+		}
+
+		// The payloads that can't be operated are not cached
+
+		if (this->_payloadLength > MAX_BIGINTEGER_SIZE)
+		{
+			temp = BigInteger(this->_payload, this->_payloadLength);
+			return &temp;
 		}
 
-		return new BigInteger(this->_payload, this->_payloadLength);
+		return this->GetCachedInteger();
 	}
 
 	inline bool GetInt32(int32 &ret)
@@ -39,6 +65,26 @@ public:
 			return true;
 		}
 
+		if (this->_payloadLength <= 4)
+		{
+			// Little endian two's complement, always fits
+
+			uint32 value = (this->_payload[this->_payloadLength - 1] & 0x80) ? 0xFFFFFFFF : 0;
+
+			for (int32 x = this->_payloadLength - 1; x >= 0; --x)
+			{
+				value = (value << 8) | this->_payload[x];
+			}
+
+			ret = (int32)value;
+			return true;
+		}
+
+		if (this->_payloadLength <= MAX_BIGINTEGER_SIZE)
+		{
+			return this->GetCachedInteger()->ToInt32(ret);
+		}
+
 		auto bi = new BigInteger(this->_payload, this->_payloadLength);
 		if (bi == nullptr) return false;
 
@@ -48,15 +94,73 @@ public:
 		return bret;
 	}
 
-	int32 ReadByteArray(byte* output, int32 sourceIndex, int32 count);
+	inline bool GetInt64(int64 &ret)
+	{
+		if (this->_payloadLength <= 8)
+		{
+			// Little endian two's complement, always fits (the empty payload is zero)
+
+			uint64 value = (this->_payloadLength > 0 && (this->_payload[this->_payloadLength - 1] & 0x80)) ? 0xFFFFFFFFFFFFFFFFULL : 0;
+
+			for (int32 x = this->_payloadLength - 1; x >= 0; --x)
+			{
+				value = (value << 8) | this->_payload[x];
+			}
+
+			ret = (int64)value;
+			return true;
+		}
+
+		if (this->_payloadLength <= MAX_BIGINTEGER_SIZE)
+		{
+			return this->GetCachedInteger()->ToInt64(ret);
+		}
+
+		return false;
+	}
+
+	inline int32 ReadByteArray(byte* output, int32 sourceIndex, int32 count)
+	{
+		if (sourceIndex < 0)
+		{
+			return -1;
+		}
+
+		int32 l = count > this->_payloadLength - sourceIndex ? this->_payloadLength - sourceIndex : count;
+
+		if (l > 0)
+		{
+			memcpy(output, &this->_payload[sourceIndex], l);
+		}
+
+		return l;
+	}
 
 	inline int32 ReadByteArraySize()
 	{
 		return this->_payloadLength;
 	}
 
+	inline int32 GetByteArrayView(const byte* &data)
+	{
+		data = this->_payload;
+		return this->_payloadLength;
+	}
+
 	bool Equals(IStackItem* it);
 
+	// Hash
+
+	inline uint32 GetHash()
+	{
+		if (this->_hash == 0)
+		{
+			this->_hash = StackItemHelper::Hash(this->_payload, this->_payloadLength);
+		}
+
+		return this->_hash;
+	}
+
 	// Constructor
 
 	ByteArrayStackItem(IStackItemCounter* counter, byte* data, int32 length, bool copyPointer);
@@ -65,11 +169,25 @@ public:
 
 	inline ~ByteArrayStackItem()
 	{
+		if (this->_integer != nullptr)
+		{
+			this->GetCounter()->MemoryDec(sizeof(BigInteger) + this->_integer->GetAllocatedSize());
+
+			delete(this->_integer);
+			this->_integer = nullptr;
+		}
+
 		if (this->_payload != nullptr)
 		{
+			this->GetCounter()->MemoryDec(sizeof(ByteArrayStackItem) + this->_payloadLength);
+
 			delete[](this->_payload);
 			this->_payload = nullptr;
 		}
+		else
+		{
+			this->GetCounter()->MemoryDec(sizeof(ByteArrayStackItem));
+		}
 	}
 
 	// Serialize
@@ -0,0 +1,347 @@
+#include "ByteKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BYTEKERNEL_X64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+// Operations
+
+class AndOp
+{
+public:
+
+	static inline byte Apply(byte a, byte b) { return a & b; }
+
+#ifdef BYTEKERNEL_X64
+	static inline __m128i Apply(__m128i a, __m128i b) { return _mm_and_si128(a, b); }
+	AVX2_TARGET static inline __m256i Apply(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+#endif
+};
+
+class OrOp
+{
+public:
+
+	static inline byte Apply(byte a, byte b) { return a | b; }
+
+#ifdef BYTEKERNEL_X64
+	static inline __m128i Apply(__m128i a, __m128i b) { return _mm_or_si128(a, b); }
+	AVX2_TARGET static inline __m256i Apply(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+#endif
+};
+
+class XorOp
+{
+public:
+
+	static inline byte Apply(byte a, byte b) { return a ^ b; }
+
+#ifdef BYTEKERNEL_X64
+	static inline __m128i Apply(__m128i a, __m128i b) { return _mm_xor_si128(a, b); }
+	AVX2_TARGET static inline __m256i Apply(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+#endif
+};
+
+// Plain loops, also used for the tails of the vectorized ones
+
+template <class Op>
+static void Pair(const byte* x, const byte* y, byte* z, int32 length)
+{
+	for (int32 i = 0; i < length; ++i)
+		z[i] = Op::Apply(x[i], y[i]);
+}
+
+template <class Op>
+static void Extend(const byte* x, byte e, byte* z, int32 length)
+{
+	for (int32 i = 0; i < length; ++i)
+		z[i] = Op::Apply(x[i], e);
+}
+
+static bool Equals(const byte* x, const byte* y, int32 length)
+{
+	for (int32 i = 0; i < length; ++i)
+		if (x[i] != y[i])
+			return false;
+
+	return true;
+}
+
+static bool IsZero(const byte* x, int32 length)
+{
+	for (int32 i = 0; i < length; ++i)
+		if (x[i] != 0x00)
+			return false;
+
+	return true;
+}
+
+#ifdef BYTEKERNEL_X64
+
+// SSE2, always available on x64
+
+template <class Op>
+static void PairSSE2(const byte* x, const byte* y, byte* z, int32 length)
+{
+	int32 i = 0;
+
+	for (; i + 16 <= length; i += 16)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i*)(x + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(y + i));
+		_mm_storeu_si128((__m128i*)(z + i), Op::Apply(a, b));
+	}
+
+	Pair<Op>(x + i, y + i, z + i, length - i);
+}
+
+template <class Op>
+static void ExtendSSE2(const byte* x, byte e, byte* z, int32 length)
+{
+	int32 i = 0;
+	__m128i b = _mm_set1_epi8((char)e);
+
+	for (; i + 16 <= length; i += 16)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i*)(x + i));
+		_mm_storeu_si128((__m128i*)(z + i), Op::Apply(a, b));
+	}
+
+	Extend<Op>(x + i, e, z + i, length - i);
+}
+
+static bool EqualsSSE2(const byte* x, const byte* y, int32 length)
+{
+	int32 i = 0;
+
+	for (; i + 16 <= length; i += 16)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i*)(x + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(y + i));
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF)
+			return false;
+	}
+
+	return Equals(x + i, y + i, length - i);
+}
+
+static bool IsZeroSSE2(const byte* x, int32 length)
+{
+	int32 i = 0;
+	__m128i acc = _mm_setzero_si128();
+
+	for (; i + 16 <= length; i += 16)
+		acc = _mm_or_si128(acc, _mm_loadu_si128((const __m128i*)(x + i)));
+
+	if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF)
+		return false;
+
+	return IsZero(x + i, length - i);
+}
+
+// AVX2, when the CPU and the OS support it
+
+template <class Op>
+AVX2_TARGET static void PairAVX2(const byte* x, const byte* y, byte* z, int32 length)
+{
+	int32 i = 0;
+
+	for (; i + 32 <= length; i += 32)
+	{
+		__m256i a = _mm256_loadu_si256((const __m256i*)(x + i));
+		__m256i b = _mm256_loadu_si256((const __m256i*)(y + i));
+		_mm256_storeu_si256((__m256i*)(z + i), Op::Apply(a, b));
+	}
+
+	PairSSE2<Op>(x + i, y + i, z + i, length - i);
+}
+
+template <class Op>
+AVX2_TARGET static void ExtendAVX2(const byte* x, byte e, byte* z, int32 length)
+{
+	int32 i = 0;
+	__m256i b = _mm256_set1_epi8((char)e);
+
+	for (; i + 32 <= length; i += 32)
+	{
+		__m256i a = _mm256_loadu_si256((const __m256i*)(x + i));
+		_mm256_storeu_si256((__m256i*)(z + i), Op::Apply(a, b));
+	}
+
+	ExtendSSE2<Op>(x + i, e, z + i, length - i);
+}
+
+AVX2_TARGET static bool EqualsAVX2(const byte* x, const byte* y, int32 length)
+{
+	int32 i = 0;
+
+	for (; i + 32 <= length; i += 32)
+	{
+		__m256i a = _mm256_loadu_si256((const __m256i*)(x + i));
+		__m256i b = _mm256_loadu_si256((const __m256i*)(y + i));
+
+		if ((uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)) != 0xFFFFFFFF)
+			return false;
+	}
+
+	return EqualsSSE2(x + i, y + i, length - i);
+}
+
+AVX2_TARGET static bool IsZeroAVX2(const byte* x, int32 length)
+{
+	int32 i = 0;
+	__m256i acc = _mm256_setzero_si256();
+
+	for (; i + 32 <= length; i += 32)
+		acc = _mm256_or_si256(acc, _mm256_loadu_si256((const __m256i*)(x + i)));
+
+	if (!_mm256_testz_si256(acc, acc))
+		return false;
+
+	return IsZeroSSE2(x + i, length - i);
+}
+
+static bool SupportsAVX2()
+{
+#ifdef _MSC_VER
+	int info[4];
+
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+
+	// OSXSAVE and AVX, then the YMM state enabled by the OS, then AVX2
+
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+	if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif
+
+// Selection
+
+class Kernels
+{
+public:
+
+	typedef void(*PairKernel)(const byte* x, const byte* y, byte* z, int32 length);
+	typedef void(*ExtendKernel)(const byte* x, byte e, byte* z, int32 length);
+	typedef bool(*EqualsKernel)(const byte* x, const byte* y, int32 length);
+	typedef bool(*IsZeroKernel)(const byte* x, int32 length);
+
+	const char* Name;
+
+	PairKernel AndPair, OrPair, XorPair;
+	ExtendKernel AndExtend, OrExtend, XorExtend;
+	EqualsKernel Equals;
+	IsZeroKernel IsZero;
+
+	static Kernels Select()
+	{
+		Kernels ret;
+
+#ifdef BYTEKERNEL_X64
+		if (SupportsAVX2())
+		{
+			ret.Name = "avx2";
+			ret.AndPair = PairAVX2<AndOp>; ret.OrPair = PairAVX2<OrOp>; ret.XorPair = PairAVX2<XorOp>;
+			ret.AndExtend = ExtendAVX2<AndOp>; ret.OrExtend = ExtendAVX2<OrOp>; ret.XorExtend = ExtendAVX2<XorOp>;
+			ret.Equals = EqualsAVX2;
+			ret.IsZero = IsZeroAVX2;
+		}
+		else
+		{
+			ret.Name = "sse2";
+			ret.AndPair = PairSSE2<AndOp>; ret.OrPair = PairSSE2<OrOp>; ret.XorPair = PairSSE2<XorOp>;
+			ret.AndExtend = ExtendSSE2<AndOp>; ret.OrExtend = ExtendSSE2<OrOp>; ret.XorExtend = ExtendSSE2<XorOp>;
+			ret.Equals = EqualsSSE2;
+			ret.IsZero = IsZeroSSE2;
+		}
+#else
+		ret.Name = "none";
+		ret.AndPair = Pair<AndOp>; ret.OrPair = Pair<OrOp>; ret.XorPair = Pair<XorOp>;
+		ret.AndExtend = Extend<AndOp>; ret.OrExtend = Extend<OrOp>; ret.XorExtend = Extend<XorOp>;
+		ret.Equals = ::Equals;
+		ret.IsZero = ::IsZero;
+#endif
+
+		return ret;
+	}
+};
+
+static const Kernels Selected = Kernels::Select();
+
+static inline void Bitwise(Kernels::PairKernel pair, Kernels::ExtendKernel extend, const byte* x, int32 xl, const byte* y, int32 yl, byte* z)
+{
+	// The common bytes, then the rest of the longer operand against the sign of the shorter one
+
+	if (xl < yl)
+	{
+		const byte* t = x; x = y; y = t;
+		int32 tl = xl; xl = yl; yl = tl;
+	}
+
+	pair(x, y, z, yl);
+
+	if (xl > yl)
+	{
+		byte e = yl > 0 && (y[yl - 1] & 0x80) != 0 ? 0xFF : 0x00;
+		extend(x + yl, e, z + yl, xl - yl);
+	}
+}
+
+void ByteKernel::And(const byte* x, int32 xl, const byte* y, int32 yl, byte* z)
+{
+	Bitwise(Selected.AndPair, Selected.AndExtend, x, xl, y, yl, z);
+}
+
+void ByteKernel::Or(const byte* x, int32 xl, const byte* y, int32 yl, byte* z)
+{
+	Bitwise(Selected.OrPair, Selected.OrExtend, x, xl, y, yl, z);
+}
+
+void ByteKernel::Xor(const byte* x, int32 xl, const byte* y, int32 yl, byte* z)
+{
+	Bitwise(Selected.XorPair, Selected.XorExtend, x, xl, y, yl, z);
+}
+
+void ByteKernel::Invert(const byte* x, int32 xl, byte* z)
+{
+	if (xl == 0)
+	{
+		z[0] = 0xFF;
+		return;
+	}
+
+	Selected.XorExtend(x, 0xFF, z, xl);
+}
+
+bool ByteKernel::Equals(const byte* x, const byte* y, int32 length)
+{
+	return Selected.Equals(x, y, length);
+}
+
+bool ByteKernel::IsZero(const byte* x, int32 length)
+{
+	return Selected.IsZero(x, length);
+}
+
+const char* ByteKernel::GetInstructionSet()
+{
+	return Selected.Name;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Types.h"
+
+// Kernels on little endian two's complement encodings, vectorized with AVX2 or SSE2
+// on x64 (chosen at runtime from CPUID) and plain loops elsewhere
+
+class ByteKernel
+{
+public:
+
+	// z = x op y, the shorter operand is sign extended and z has max(xl, yl) bytes
+
+	static void And(const byte* x, int32 xl, const byte* y, int32 yl, byte* z);
+	static void Or(const byte* x, int32 xl, const byte* y, int32 yl, byte* z);
+	static void Xor(const byte* x, int32 xl, const byte* y, int32 yl, byte* z);
+
+	// z = ~x, z has max(xl, 1) bytes (the empty encoding is zero)
+
+	static void Invert(const byte* x, int32 xl, byte* z);
+
+	static bool Equals(const byte* x, const byte* y, int32 length);
+	static bool IsZero(const byte* x, int32 length);
+
+	// Name of the selected instruction set
+
+	static const char* GetInstructionSet();
+};
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Types.h"
+
+// 64 bits arithmetic that reports the overflow instead of wrapping,
+// the operation is done only when the result fits
+
+class CheckedMath
+{
+private:
+
+	const static int64 Int64MaxValue = 0x7FFFFFFFFFFFFFFFLL;
+	const static int64 Int64MinValue = -Int64MaxValue - 1;
+
+public:
+
+	static inline bool Add(int64 a, int64 b, int64 &ret)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return !__builtin_add_overflow(a, b, &ret);
+#else
+		if ((b > 0 && a > Int64MaxValue - b) || (b < 0 && a < Int64MinValue - b))
+		{
+			return false;
+		}
+
+		ret = a + b;
+		return true;
+#endif
+	}
+
+	static inline bool Sub(int64 a, int64 b, int64 &ret)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return !__builtin_sub_overflow(a, b, &ret);
+#else
+		if ((b < 0 && a > Int64MaxValue + b) || (b > 0 && a < Int64MinValue + b))
+		{
+			return false;
+		}
+
+		ret = a - b;
+		return true;
+#endif
+	}
+
+	static inline bool Mul(int64 a, int64 b, int64 &ret)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return !__builtin_mul_overflow(a, b, &ret);
+#else
+		if (a == 0 || b == 0)
+		{
+			ret = 0;
+			return true;
+		}
+
+		if ((a == -1 && b == Int64MinValue) || (b == -1 && a == Int64MinValue))
+		{
+			return false;
+		}
+
+		int64 value = (int64)((uint64)a * (uint64)b);
+
+		if (value / b != a)
+		{
+			return false;
+		}
+
+		ret = value;
+		return true;
+#endif
+	}
+
+	static inline bool Inc(int64 a, int64 &ret)
+	{
+		return Add(a, 1, ret);
+	}
+
+	static inline bool Dec(int64 a, int64 &ret)
+	{
+		return Sub(a, 1, ret);
+	}
+
+	// Can't overflow, here for the same signature
+
+	static inline bool Min(int64 a, int64 b, int64 &ret)
+	{
+		ret = a >= b ? b : a;
+		return true;
+	}
+
+	static inline bool Max(int64 a, int64 b, int64 &ret)
+	{
+		ret = a >= b ? a : b;
+		return true;
+	}
+
+	static inline bool Negate(int64 a, int64 &ret)
+	{
+		if (a == Int64MinValue)
+		{
+			return false;
+		}
+
+		ret = -a;
+		return true;
+	}
+
+	static inline bool Abs(int64 a, int64 &ret)
+	{
+		if (a == Int64MinValue)
+		{
+			return false;
+		}
+
+		ret = a < 0 ? -a : a;
+		return true;
+	}
+};
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include "Crypto.h"
+#include "Limits.h"
 #include <string.h>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 
 #include <openssl/ec.h>      // for EC_GROUP_new_by_curve_name, EC_GROUP_free, EC_KEY_new, EC_KEY_set_group, EC_KEY_generate_key, EC_KEY_free
 #include <openssl/ecdsa.h>   // for ECDSA_do_sign, ECDSA_do_verify
@@ -30,17 +34,179 @@ const byte Crypto::EMPTY_HASH256[] =
 	0x03,0x81,0x53,0x45,0x45,0xf5,0x5c,0xf4,0x3e,0x41,0x98,0x3f,0x5d,0x4c,0x94,0x56
 };
 
+// Decoded public keys by encoding, the least recently used is evicted when it's full.
+// The keys are only read once decoded, so they can be used by several threads at the same time
+
+class PublicKeyCache
+{
+private:
+
+	class Key
+	{
+	public:
+
+		byte Data[65];
+		int32 Length;
+
+		inline Key(const byte* data, int32 length) : Length(length)
+		{
+			memcpy(this->Data, data, length);
+		}
+
+		inline bool operator==(const Key &other) const
+		{
+			return this->Length == other.Length && memcmp(this->Data, other.Data, this->Length) == 0;
+		}
+	};
+
+	class KeyHash
+	{
+	public:
+
+		inline std::size_t operator()(const Key &key) const
+		{
+			// FNV-1a
+
+			uint32 hash = 2166136261U;
+
+			for (int32 x = 0; x < key.Length; ++x)
+				hash = (hash ^ key.Data[x]) * 16777619U;
+
+			return hash;
+		}
+	};
+
+	typedef std::list<std::pair<Key, EC_KEY*>> Entries;
+
+	std::mutex _lock;
+	EC_GROUP* _group;
+	Entries _entries;
+	std::unordered_map<Key, Entries::iterator, KeyHash> _index;
+
+	EC_KEY* Decode(const byte* pubKey, int32 pubKeyLength)
+	{
+		EC_KEY* key = EC_KEY_new();
+		EC_POINT* point = EC_POINT_new(this->_group);
+
+		// The compressed keys need a modular square root, this is the cost that is cached
+
+		bool ok = key != nullptr && point != nullptr &&
+			EC_KEY_set_group(key, this->_group) == 0x01 &&
+			EC_POINT_oct2point(this->_group, point, pubKey, pubKeyLength, nullptr) == 0x01 &&
+			EC_KEY_set_public_key(key, point) == 0x01;
+
+		if (point != nullptr) EC_POINT_free(point);
+
+		if (!ok && key != nullptr)
+		{
+			EC_KEY_free(key);
+			key = nullptr;
+		}
+
+		return key;
+	}
+
+public:
+
+	inline PublicKeyCache(int32 curve) : _group(EC_GROUP_new_by_curve_name(curve)) { }
+
+	EC_KEY* Get(const byte* pubKey, int32 pubKeyLength)
+	{
+		Key key(pubKey, pubKeyLength);
+
+		{
+			std::lock_guard<std::mutex> lock(this->_lock);
+
+			auto it = this->_index.find(key);
+
+			if (it != this->_index.end())
+			{
+				this->_entries.splice(this->_entries.begin(), this->_entries, it->second);
+				EC_KEY_up_ref(it->second->second);
+
+				return it->second->second;
+			}
+		}
+
+		// Decoded out of the lock, so the other threads don't wait for it
+
+		if (this->_group == nullptr)
+		{
+			return nullptr;
+		}
+
+		EC_KEY* decoded = this->Decode(pubKey, pubKeyLength);
+
+		if (decoded == nullptr)
+		{
+			return nullptr;
+		}
+
+		std::lock_guard<std::mutex> lock(this->_lock);
+
+		auto it = this->_index.find(key);
+
+		if (it != this->_index.end())
+		{
+			// Added by another thread meanwhile
+
+			EC_KEY_free(decoded);
+			EC_KEY_up_ref(it->second->second);
+
+			return it->second->second;
+		}
+
+		if ((int32)this->_entries.size() >= MAX_PUBLIC_KEY_CACHE_SIZE)
+		{
+			this->_index.erase(this->_entries.back().first);
+			EC_KEY_free(this->_entries.back().second);
+			this->_entries.pop_back();
+		}
+
+		this->_entries.push_front(std::make_pair(key, decoded));
+		this->_index.emplace(key, this->_entries.begin());
+
+		// One reference for the cache, one for the caller
+
+		EC_KEY_up_ref(decoded);
+		return decoded;
+	}
+};
+
+EC_KEY* Crypto::GetPublicKey(const byte* pubKey, int32 pubKeyLength)
+{
+	// Never freed, it lives as long as the process (and after the engines that use it)
+
+	static PublicKeyCache* cache = new PublicKeyCache(_curve);
+
+	return cache->Get(pubKey, pubKeyLength);
+}
+
 int16 Crypto::VerifySignature
 (
-	byte* data, int32 dataLength,
-	byte* signature, int32 signatureLength,
-	byte* pubKey, int32 pubKeyLength
+	const byte* data, int32 dataLength,
+	const byte* signature, int32 signatureLength,
+	const byte* pubKey, int32 pubKeyLength
+)
+{
+	byte hash[Crypto::SHA256_LENGTH];
+	ComputeSHA256(data, dataLength, hash);
+
+	return VerifyDigest(hash, signature, signatureLength, pubKey, pubKeyLength);
+}
+
+int16 Crypto::VerifyDigest
+(
+	const byte* hash,
+	const byte* signature, int32 signatureLength,
+	const byte* pubKey, int32 pubKeyLength
 )
 {
 	if (signatureLength != 64)
 		return -1;
 
-	byte* realPubKey = nullptr;
+	const byte* realPubKey = nullptr;
+	byte uncompressedPubKey[65];
 	int32 realPublicKeyLength = 65;
 
 	if (pubKeyLength == 33 && (pubKey[0] == 0x02 || pubKey[0] == 0x03))
@@ -52,17 +218,17 @@ int16 Crypto::VerifySignature
 	{
 		// 0x04 first
 
-		realPubKey = new byte[65];
-		realPubKey[0] = 0x04;
+		uncompressedPubKey[0] = 0x04;
 
-		memcpy(&realPubKey[1], pubKey, 64);
+		memcpy(&uncompressedPubKey[1], pubKey, 64);
+		realPubKey = uncompressedPubKey;
 	}
 	else if (pubKeyLength == 65)
 	{
 		if (pubKey[0] != 0x04)
 			return -1;
 
-		realPubKey = data;
+		realPubKey = pubKey;
 	}
 	else if (pubKeyLength != 65)
 	{
@@ -70,72 +236,41 @@ int16 Crypto::VerifySignature
 	}
 
 	int32 ret = -1;
-	EC_GROUP* ecgroup = EC_GROUP_new_by_curve_name(_curve);
+	EC_KEY* eckey = GetPublicKey(realPubKey, realPublicKeyLength);
 
-	if (ecgroup != nullptr)
+	if (eckey != nullptr)
 	{
-		EC_KEY* eckey = EC_KEY_new_by_curve_name(_curve);
+		// DER encoding
 
-		if (eckey != nullptr)
-		{
-			BIGNUM* bn = BN_bin2bn(realPubKey, realPublicKeyLength, nullptr);
-			EC_POINT* pub = EC_POINT_bn2point(ecgroup, bn, nullptr, nullptr);
+		BIGNUM* r = BN_bin2bn(&signature[0], 32, nullptr);
+		BIGNUM* s = BN_bin2bn(&signature[32], 32, nullptr);
 
-			if (pub != nullptr)
-			{
-				int32 gen_status = EC_KEY_set_public_key(eckey, pub);
-
-				if (gen_status == 0x01)
-				{
-					// DER encoding
-
-					BIGNUM* r = BN_bin2bn(&signature[0], 32, nullptr);
-					BIGNUM* s = BN_bin2bn(&signature[32], 32, nullptr);
-
-					ECDSA_SIG* sig = ECDSA_SIG_new();
-					gen_status = ECDSA_SIG_set0(sig, r, s);
-
-					if (sig != nullptr)
-					{
-						if (gen_status == 0x01)
-						{
-							byte hash[Crypto::SHA256_LENGTH];
-							ComputeSHA256(data, dataLength, hash);
-							ret = ECDSA_do_verify(hash, Crypto::SHA256_LENGTH, sig, eckey);
-						}
-
-						// Free r,s and sig
-
-						ECDSA_SIG_free(sig);
-					}
-					else
-					{
-						// TODO: Check this free
-
-						BN_free(r);
-						BN_free(s);
-					}
-				}
-
-				EC_POINT_free(pub);
-				BN_free(bn);
-			}
-			EC_KEY_free(eckey);
+		ECDSA_SIG* sig = ECDSA_SIG_new();
+
+		if (sig != nullptr && ECDSA_SIG_set0(sig, r, s) == 0x01)
+		{
+			ret = ECDSA_do_verify(hash, Crypto::SHA256_LENGTH, sig, eckey);
+		}
+		else
+		{
+			BN_free(r);
+			BN_free(s);
 		}
-		EC_GROUP_free(ecgroup);
-	}
 
-	// free
+		// Free r,s and sig
 
-	if (realPubKey != pubKey)
-	{
-		delete[](realPubKey);
+		if (sig != nullptr)
+		{
+			ECDSA_SIG_free(sig);
+		}
+
+		EC_KEY_free(eckey);
 	}
 
 	return ret == 0x01 ? 0x01 : 0x00;
 }
 
-void Crypto::ComputeHash160(byte* data, int32 length, byte* output)
+void Crypto::ComputeHash160(const byte* data, int32 length, byte* output)
 {
 	if (length <= 0)
 	{
@@ -159,7 +294,7 @@ void Crypto::ComputeHash160(byte* data, int32 length, byte* output)
 	OPENSSL_cleanse(&c, sizeof(c));
 }
 
-void Crypto::ComputeHash256(byte* data, int32 length, byte* output)
+void Crypto::ComputeHash256(const byte* data, int32 length, byte* output)
 {
 	if (length <= 0)
 	{
@@ -178,7 +313,7 @@ void Crypto::ComputeHash256(byte* data, int32 length, byte* output)
 	ComputeSHA256(digest, SHA256_LENGTH, output);
 }
 
-void Crypto::ComputeSHA256(byte* data, int32 length, byte* output)
+void Crypto::ComputeSHA256(const byte* data, int32 length, byte* output)
 {
 	if (length <= 0)
 	{
@@ -193,7 +328,7 @@ void Crypto::ComputeSHA256(byte* data, int32 length, byte* output)
 	OPENSSL_cleanse(&c, sizeof(c));
 }
 
-void Crypto::ComputeSHA1(byte* data, int32 length, byte* output)
+void Crypto::ComputeSHA1(const byte* data, int32 length, byte* output)
 {
 	if (length <= 0)
 	{
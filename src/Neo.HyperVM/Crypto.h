@@ -2,6 +2,7 @@
 
 #include "Types.h"
 #include <openssl/obj_mac.h> // for NID_secp192k1
+#include <openssl/ec.h>      // for EC_KEY
 
 class Crypto
 {
@@ -16,18 +17,26 @@ public:
 
 	// Methods
 
-	static void ComputeSHA1(byte* data, int32 length, byte* output);
-	static void ComputeSHA256(byte* data, int32 length, byte* output);
-	static void ComputeHash160(byte* data, int32 length, byte* output);
-	static void ComputeHash256(byte* data, int32 length, byte* output);
+	static void ComputeSHA1(const byte* data, int32 length, byte* output);
+	static void ComputeSHA256(const byte* data, int32 length, byte* output);
+	static void ComputeHash160(const byte* data, int32 length, byte* output);
+	static void ComputeHash256(const byte* data, int32 length, byte* output);
 
 	// -1=ERROR , 0= False , 1=True 
-	static int16 VerifySignature(byte* data, int32 dataLength, byte* signature, int32 signatureLength, byte* pubKey, int32 pubKeyLength);
+	static int16 VerifySignature(const byte* data, int32 dataLength, const byte* signature, int32 signatureLength, const byte* pubKey, int32 pubKeyLength);
+
+	// Same as VerifySignature, with the SHA256 of the data already computed
+	static int16 VerifyDigest(const byte* hash, const byte* signature, int32 signatureLength, const byte* pubKey, int32 pubKeyLength);
 
 private:
 
 	static const int32 _curve = NID_X9_62_prime256v1;
 
+	// Decoded public key from the shared cache, null when it's not valid.
+	// The caller owns a reference and must release it with EC_KEY_free
+
+	static EC_KEY* GetPublicKey(const byte* pubKey, int32 pubKeyLength);
+
 	// Empty hashes
 
 	static const byte EMPTY_HASH160[HASH160_LENGTH];
@@ -0,0 +1,132 @@
+#include "CycleCollector.h"
+#include "ArrayStackItem.h"
+#include "MapStackItem.h"
+#include "StackItemHelper.h"
+#include <vector>
+
+template<typename F>
+inline void CycleCollector::ForEachChild(ICompoundStackItem* item, std::unordered_set<void*> &storages, F action)
+{
+	if (item->Type == EStackItemType::Map)
+	{
+		auto map = (MapStackItem*)item;
+
+		for (auto it = map->_entries.begin(); it != map->_entries.end(); ++it)
+		{
+			if (it->Key == nullptr) continue;
+
+			if (it->Key->Type == EStackItemType::Array || it->Key->Type == EStackItemType::Struct || it->Key->Type == EStackItemType::Map)
+				action((ICompoundStackItem*)it->Key);
+
+			if (it->Value->Type == EStackItemType::Array || it->Value->Type == EStackItemType::Struct || it->Value->Type == EStackItemType::Map)
+				action((ICompoundStackItem*)it->Value);
+		}
+
+		return;
+	}
+
+	// The items of a shared storage are claimed once, for all its owners
+
+	auto storage = ((ArrayStackItem*)item)->_storage;
+
+	if (storage->Owners > 1 && !storages.insert(storage).second)
+	{
+		return;
+	}
+
+	for (auto it = storage->Items.begin(); it != storage->Items.end(); ++it)
+	{
+		if (ArrayStackItem::IsPacked(*it)) continue;
+
+		auto child = ArrayStackItem::ToItem(*it);
+
+		if (child != nullptr && (child->Type == EStackItemType::Array || child->Type == EStackItemType::Struct || child->Type == EStackItemType::Map))
+			action((ICompoundStackItem*)child);
+	}
+}
+
+int32 CycleCollector::Collect(IStackItemCounter* counter)
+{
+	std::unordered_set<void*> storages;
+
+	// Discount the claims between compound items, what remains comes from the stacks or the host
+
+	for (auto item = counter->_compounds; item != nullptr; item = item->_nextCompound)
+	{
+		item->_externalClaims = item->GetClaims();
+	}
+
+	for (auto item = counter->_compounds; item != nullptr; item = item->_nextCompound)
+	{
+		ForEachChild(item, storages, [](ICompoundStackItem* child)
+		{
+			child->_externalClaims--;
+		});
+	}
+
+	// Mark everything reachable from the externally claimed items
+
+	std::vector<ICompoundStackItem*> pending;
+	storages.clear();
+
+	for (auto item = counter->_compounds; item != nullptr; item = item->_nextCompound)
+	{
+		if (item->_externalClaims <= 0) continue;
+
+		item->_externalClaims = Reachable;
+		pending.push_back(item);
+
+		while (!pending.empty())
+		{
+			auto live = pending.back();
+			pending.pop_back();
+
+			ForEachChild(live, storages, [&pending](ICompoundStackItem* child)
+			{
+				if (child->_externalClaims != Reachable)
+				{
+					child->_externalClaims = Reachable;
+					pending.push_back(child);
+				}
+			});
+		}
+	}
+
+	// The rest is garbage
+
+	std::vector<ICompoundStackItem*> garbage;
+
+	for (auto item = counter->_compounds; item != nullptr; item = item->_nextCompound)
+	{
+		if (item->_externalClaims != Reachable)
+			garbage.push_back(item);
+	}
+
+	// Hold them while the references between them are broken, then free them
+
+	for (auto it = garbage.begin(); it != garbage.end(); ++it)
+	{
+		(*it)->Claim();
+	}
+
+	for (auto it = garbage.begin(); it != garbage.end(); ++it)
+	{
+		if ((*it)->Type == EStackItemType::Map)
+			((MapStackItem*)*it)->Clear();
+		else
+			((ArrayStackItem*)*it)->Clear();
+	}
+
+	for (auto it = garbage.begin(); it != garbage.end(); ++it)
+	{
+		IStackItem* item = *it;
+		StackItemHelper::UnclaimAndFree(item);
+	}
+
+	// Next collection when half of the remaining headroom is used
+
+	int32 headroom = (counter->_maxItems - counter->_items) / 2;
+	counter->_collectAt = counter->_items + (headroom > MinCollectInterval ? headroom : MinCollectInterval);
+
+	return static_cast<int32>(garbage.size());
+}
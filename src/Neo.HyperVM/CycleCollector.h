@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Types.h"
+#include "IStackItemCounter.h"
+#include "ICompoundStackItem.h"
+#include <unordered_set>
+
+class CycleCollector
+{
+private:
+
+	// Mark for the items reachable from outside the compound items
+
+	static const int32 Reachable = -1;
+
+	// Headroom consumed before the next collection
+
+	static const int32 MinCollectInterval = 32;
+
+	template<typename F>
+	static void ForEachChild(ICompoundStackItem* item, std::unordered_set<void*> &storages, F action);
+
+public:
+
+	// Trial deletion, free the compound items that are only claimed by unreachable cycles.
+	// It's deterministic (only depends on the items), returns the number of freed items
+
+	static int32 Collect(IStackItemCounter* counter);
+};
@@ -13,4 +13,6 @@ enum EVMState : byte
 	FAULT = 2,
 	// Out of gas
 	FAULT_BY_GAS = 3,
+	// Memory limit exceeded (ExecutionEngine.FaultByMemory in the interop)
+	FAULT_BY_MEMORY = 4,
 };
\ No newline at end of file
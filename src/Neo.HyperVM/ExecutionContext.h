@@ -3,24 +3,39 @@
 #include <memory>
 #include "EVMOpCode.h"
 #include "Types.h"
+#include "IClaimable.h"
 #include "StackItems.h"
 #include "ExecutionScript.h"
 
-class ExecutionContext
+class ExecutionContext : public IClaimable
 {
 private:
 
+	friend class ExecutionContextStack;
+
 	std::shared_ptr<ExecutionScript> _script;
 	int32 _instructionIndex;
 	byte* _instructionPointer;
 	byte _buffer[8];
 
-	const int32 _scriptLength;
-	bool _isGarbageCollected;
+	int32 _scriptLength;
+
+	// Reuse a recycled context
+
+	inline void Reset(std::shared_ptr<ExecutionScript> script, int32 instructorPointer, int32 rvcount)
+	{
+		this->_script = script;
+		this->_instructionIndex = instructorPointer;
+		this->_instructionPointer = &script->Content[instructorPointer];
+		this->_scriptLength = script->ScriptLength;
+		this->RVCount = rvcount;
+
+		this->EvaluationStack.Link();
+	}
 
 public:
 
-	const int32 RVCount;
+	int32 RVCount;
 
 	// Stacks
 
@@ -68,15 +83,6 @@ public:
 		return (EVMOpCode)*(this->_instructionPointer++);
 	}
 
-	inline ExecutionContext* Clone(int32 rvcount, int32 pcount)
-	{
-		auto clone = new ExecutionContext(this->_script, this->_instructionIndex, rvcount);
-
-		this->EvaluationStack.SendTo(&clone->EvaluationStack, pcount);
-
-		return clone;
-	}
-
 	inline bool CouldSeekFromHere(int32 offset) const
 	{
 		int32 newPos = this->_instructionIndex + offset;
@@ -113,7 +119,8 @@ public:
 
 	// Constructor
 
-	inline ExecutionContext(std::shared_ptr<ExecutionScript> script, int32 instructorPointer, int32 rvcount) :
+	inline ExecutionContext(std::shared_ptr<ExecutionScript> script, int32 instructorPointer, int32 rvcount, ValueStack* values) :
+		IClaimable(),
 		_script(script),
 		_instructionIndex(instructorPointer),
 		_instructionPointer(&script->Content[instructorPointer]),
@@ -121,28 +128,18 @@ public:
 		_scriptLength(script->ScriptLength),
 		RVCount(rvcount),
 		AltStack(),
-		EvaluationStack(),
-		_isGarbageCollected(false)
+		EvaluationStack(values)
 	{
 		
 	}
 
 	// Destructor
 
-	inline bool Collect()
-	{
-		if (this->_isGarbageCollected)
-		{
-			return false;
-		}
-
-		this->_isGarbageCollected = true;
-		return true;
-	}
-
 	inline void Clear()
 	{
-		this->EvaluationStack.Clear();
+		// Release the window, the next contexts are moved down
+
+		this->EvaluationStack.Unlink();
 		this->AltStack.Clear();
 	}
 
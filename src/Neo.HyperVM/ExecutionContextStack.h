@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ExecutionContext.h"
+#include "ValueStack.h"
 #include "Stack.h"
 
 class ExecutionContextStack
@@ -8,7 +9,15 @@ class ExecutionContextStack
 private:
 
 	Stack<ExecutionContext> _stack;
-	Stack<ExecutionContext> _gc;
+
+	// Released contexts, reused with their stacks
+
+	Stack<ExecutionContext> _pool;
+	ValueStack* _values;
+
+	// Released contexts that the host still points to, not reused until the host releases them too
+
+	Stack<ExecutionContext> _claimed;
 
 public:
 
@@ -27,14 +36,36 @@ public:
 		return this->_stack.Peek(index);
 	}
 
-	inline void Push(ExecutionContext* i)
+	inline ExecutionContext* Push(std::shared_ptr<ExecutionScript> script, int32 instructionPointer, int32 rvcount)
 	{
-		if (i->Collect()) 
+		ExecutionContext* context;
+
+		if (this->_pool.Count() > 0)
+		{
+			context = this->_pool.Pop();
+			context->Reset(script, instructionPointer, rvcount);
+		}
+		else
 		{
-			this->_gc.Push(i);
+			context = new ExecutionContext(script, instructionPointer, rvcount, this->_values);
 		}
 
-		this->_stack.Push(i);
+		this->_stack.Push(context);
+		return context;
+	}
+
+	inline ExecutionContext* PushClone(ExecutionContext* context, int32 rvcount, int32 pcount)
+	{
+		auto clone = this->Push(context->_script, context->_instructionIndex, rvcount);
+
+		context->EvaluationStack.SendTo(&clone->EvaluationStack, pcount);
+
+		return clone;
+	}
+
+	inline ExecutionContext* PushCopy(ExecutionContext* context)
+	{
+		return this->Push(context->_script, context->_instructionIndex, context->RVCount);
 	}
 
 	inline ExecutionContext* Pop(int32 index)
@@ -47,21 +78,85 @@ public:
 		return this->_stack.Pop();
 	}
 
+	inline void Recycle(ExecutionContext* context)
+	{
+		if (context == nullptr) return;
+
+		context->Clear();
+
+		if (!context->IsUnClaimed())
+		{
+			// Keep the script, so the host can still read the hash and the instruction pointer
+
+			this->_claimed.Push(context);
+			return;
+		}
+
+		context->_script = nullptr;
+
+		this->_pool.Push(context);
+	}
+
+	// Free the contexts claimed by the host, their wrappers belong to the previous owner of the engine
+
+	// Send the contexts that the host has released to the pool
+
+	inline void RecycleUnClaimed()
+	{
+		for (int32 x = this->_claimed.Count() - 1; x >= 0; x--)
+		{
+			auto context = this->_claimed.Peek(x);
+
+			if (!context->IsUnClaimed()) continue;
+
+			this->_claimed.Pop(x);
+
+			context->_script = nullptr;
+			this->_pool.Push(context);
+		}
+	}
+
+	inline void FreeClaimed()
+	{
+		for (int32 x = 0, count = this->_claimed.Count(); x < count; x++)
+		{
+			auto ptr = this->_claimed.Peek(x);
+			delete(ptr);
+		}
+
+		this->_claimed.Clear();
+	}
+
 	inline void Clear()
 	{
+		for (int32 x = 0, count = this->_stack.Count(); x < count; x++)
+		{
+			this->Recycle(this->_stack.Peek(x));
+		}
+
 		this->_stack.Clear();
 	}
 
+	// Constructor & Destructor
+
+	inline ExecutionContextStack(ValueStack* values) :
+		_stack(),
+		_pool(),
+		_values(values),
+		_claimed()
+	{ }
+
 	inline ~ExecutionContextStack()
 	{
 		this->Clear();
 
-		for (int32 x = 0, count = this->_gc.Count(); x < count; x++)
+		for (int32 x = 0, count = this->_pool.Count(); x < count; x++)
 		{
-			auto ptr = this->_stack.Peek(x);
+			auto ptr = this->_pool.Peek(x);
 			delete(ptr);
 		}
 
-		this->_gc.Clear();
+		this->_pool.Clear();
+		this->FreeClaimed();
 	}
-};
\ No newline at end of file
+};
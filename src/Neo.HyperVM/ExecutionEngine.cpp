@@ -7,22 +7,206 @@
 #include "ArrayStackItem.h"
 #include "Crypto.h"
 #include "StackItemHelper.h"
+#include "StackItemConverter.h"
+#include "Stack.h"
+#include "CycleCollector.h"
+#include "StackItemCopier.h"
+#include "CheckedMath.h"
+#include "ByteKernel.h"
+#include "ScratchBuffer.h"
+#include "SignatureVerifier.h"
+#include <algorithm>
 
 // Setters
 
+void ExecutionEngine::SetMessage(const byte* message, int32 messageLength, const byte* hash)
+{
+	this->_messageLoaded = true;
+	this->_messageLength = messageLength > 0 ? messageLength : 0;
+
+	if (this->_messageLength == 0)
+	{
+		return;
+	}
+
+	if (hash != nullptr)
+	{
+		memcpy(this->_messageHash, hash, Crypto::SHA256_LENGTH);
+	}
+	else
+	{
+		Crypto::ComputeSHA256(message, messageLength, this->_messageHash);
+	}
+}
+
+const byte* ExecutionEngine::GetMessageHash()
+{
+	// The host is only asked once per iteration, even when it has no message
+
+	if (!this->_messageLoaded)
+	{
+		this->_messageLoaded = true;
+		this->_messageLength = 0;
+
+		if (this->OnGetMessage != nullptr)
+		{
+			byte* msg;
+			int32 msgL = this->OnGetMessage(this->_iteration, msg);
+
+			if (msgL > 0)
+			{
+				this->_messageLength = msgL;
+				Crypto::ComputeSHA256(msg, msgL, this->_messageHash);
+			}
+		}
+	}
+
+	return this->_messageLength > 0 ? this->_messageHash : nullptr;
+}
+
 void ExecutionEngine::Clean(uint32 iteration)
 {
 	this->_iteration = iteration;
+	this->_messageLoaded = false;
 	this->_state = EVMState::NONE;
 	this->_consumedGas = 0;
 	this->_maxGas = 0xFFFFFFFF;
 
 	this->InvocationStack.Clear();
+	this->InvocationStack.RecycleUnClaimed();
 	this->ResultStack.Clear();
 
+	// Cycles left by the previous execution
+
+	CycleCollector::Collect(this->_counter);
 	this->_counter->ItemCounterClean();
 }
 
+bool ExecutionEngine::Reset(InvokeInteropCallback &invokeInterop, LoadScriptCallback &loadScript, GetMessageCallback &getMessage)
+{
+	this->Log = nullptr;
+	this->OnGetMessage = getMessage;
+	this->OnLoadScript = loadScript;
+	this->OnInvokeInterop = invokeInterop;
+
+	this->InvocationStack.Clear();
+	this->InvocationStack.FreeClaimed();
+	this->ResultStack.Clear();
+
+	CycleCollector::Collect(this->_counter);
+
+	// Items still held by the host keep the old counter, so they can't be charged to the next execution
+
+	if (this->_counter->GetClaims() > 1)
+	{
+		auto counter = new IStackItemCounter(MAX_STACK_SIZE);
+
+		if (!counter->IsRegistered())
+		{
+			delete(counter);
+			return false;
+		}
+
+		this->_counter->UnClaim();
+		this->_counter = counter;
+		this->_counter->Claim();
+	}
+	else
+	{
+		this->_counter->SetMaxMemory(0x7FFFFFFFFFFFFFFFLL);
+		this->_counter->ItemCounterClean();
+	}
+
+	// Move the loaded scripts to the cache, the most recent first
+
+	for (auto it = this->Scripts.begin(); it != this->Scripts.end(); ++it)
+	{
+		auto cached = std::find(this->_scriptCache.begin(), this->_scriptCache.end(), *it);
+
+		if (cached != this->_scriptCache.end())
+		{
+			this->_scriptCache.splice(this->_scriptCache.begin(), this->_scriptCache, cached);
+		}
+		else
+		{
+			this->_scriptCache.push_front(*it);
+		}
+	}
+
+	while ((int32)this->_scriptCache.size() > MAX_SCRIPT_CACHE_SIZE)
+	{
+		this->_scriptCache.pop_back();
+	}
+
+	this->Scripts.clear();
+
+	this->_iteration = 0;
+	this->_verificationThreads = 1;
+	this->_messageLoaded = false;
+	this->_state = EVMState::NONE;
+	this->_consumedGas = 0;
+	this->_maxGas = 0xFFFFFFFF;
+
+	return true;
+}
+
+ExecutionEngine* ExecutionEngine::Fork(InvokeInteropCallback &invokeInterop, LoadScriptCallback &loadScript, GetMessageCallback &getMessage)
+{
+	auto fork = new ExecutionEngine(invokeInterop, loadScript, getMessage);
+
+	if (!fork->IsValid())
+	{
+		delete(fork);
+		return nullptr;
+	}
+
+	fork->_iteration = this->_iteration;
+	fork->_state = this->_state;
+	fork->_consumedGas = this->_consumedGas;
+	fork->_maxGas = this->_maxGas;
+	fork->_verificationThreads = this->_verificationThreads;
+	fork->_messageLoaded = this->_messageLoaded;
+	fork->_messageLength = this->_messageLength;
+	memcpy(fork->_messageHash, this->_messageHash, Crypto::SHA256_LENGTH);
+
+	// The scripts are read only, both engines use the same
+
+	fork->Scripts = this->Scripts;
+	fork->_scriptCache = this->_scriptCache;
+
+	// Items are copied into the counter of the fork, from the entry context to the current one
+
+	StackItemCopier copier(fork->_counter);
+
+	for (int32 x = this->InvocationStack.Count() - 1; x >= 0; --x)
+	{
+		auto context = this->InvocationStack.Peek(x);
+		auto copy = fork->InvocationStack.PushCopy(context);
+
+		for (int32 y = context->EvaluationStack.Count() - 1; y >= 0; --y)
+		{
+			copy->EvaluationStack.Push(copier.Copy(context->EvaluationStack.Peek(y)));
+		}
+
+		for (int32 y = context->AltStack.Count() - 1; y >= 0; --y)
+		{
+			copy->AltStack.Push(copier.Copy(context->AltStack.Peek(y)));
+		}
+	}
+
+	for (int32 y = this->ResultStack.Count() - 1; y >= 0; --y)
+	{
+		fork->ResultStack.Push(copier.Copy(this->ResultStack.Peek(y)));
+	}
+
+	// Pending cycles are copied too, so both engines collect them at the same point
+
+	copier.CopyCompounds(this->_counter);
+	fork->_counter->ItemCounterCopy(this->_counter);
+
+	return fork;
+}
+
 // Constructor
 
 ExecutionEngine::ExecutionEngine
@@ -33,14 +217,18 @@ ExecutionEngine::ExecutionEngine
 	_consumedGas(0),
 	_maxGas(0xFFFFFFFF),
 	_counter(new IStackItemCounter(MAX_STACK_SIZE)),
+	_verificationThreads(1),
+	_messageLoaded(false),
+	_messageLength(0),
 	_state(EVMState::NONE),
 	Log(nullptr),
 
 	OnGetMessage(getMessage),
 	OnLoadScript(loadScript),
 	OnInvokeInterop(invokeInterop),
+	_valueStack(MAX_STACK_SIZE),
 	ResultStack(),
-	InvocationStack()
+	InvocationStack(&_valueStack)
 {
 	_counter->Claim();
 }
@@ -49,25 +237,28 @@ ExecutionEngine::ExecutionEngine
 
 ExecutionEngine::~ExecutionEngine()
 {
+	// Clean stacks
+
+	this->InvocationStack.Clear();
+	this->ResultStack.Clear();
+	this->Scripts.clear();
+	this->_scriptCache.clear();
+
+	// Free the cycles, the counter must be alive
+
+	CycleCollector::Collect(this->_counter);
+
 	// Clean callbacks
 
 	if (this->_counter->UnClaim())
 	{
 		delete(this->_counter);
 	}
-
-	// Clean stacks
-
-	this->InvocationStack.Clear();
-	this->ResultStack.Clear();
-	this->Scripts.clear();
 }
 
 ExecutionContext* ExecutionEngine::LoadScript(std::shared_ptr<ExecutionScript> script, int32 rvcount)
 {
-	auto context = new ExecutionContext(script, 0, rvcount);
-	this->InvocationStack.Push(context);
-	return context;
+	return this->InvocationStack.Push(script, 0, rvcount);
 }
 
 bool ExecutionEngine::LoadScript(byte scriptIndex, int32 rvcount)
@@ -84,20 +275,39 @@ bool ExecutionEngine::LoadScript(byte scriptIndex, int32 rvcount)
 
 	if (sc == nullptr) return false;
 
-	auto context = new ExecutionContext(sc, 0, rvcount);
-	this->InvocationStack.Push(context);
+	this->InvocationStack.Push(sc, 0, rvcount);
 	return true;
 }
 
+std::shared_ptr<ExecutionScript> ExecutionEngine::GetCachedScript(byte* script, int32 scriptLength)
+{
+	for (auto it = this->_scriptCache.begin(); it != this->_scriptCache.end(); ++it)
+	{
+		auto ptr = (std::shared_ptr<ExecutionScript>)*it;
+
+		if (ptr->ScriptLength == scriptLength && memcmp(ptr->Content, script, scriptLength) == 0)
+		{
+			return ptr;
+		}
+	}
+
+	return nullptr;
+}
+
 int32 ExecutionEngine::LoadScript(byte* script, int32 scriptLength, int32 rvcount)
 {
 	int32 index = Scripts.size();
 
-	auto sc = std::shared_ptr<ExecutionScript>(new ExecutionScript(script, scriptLength));
+	auto sc = this->GetCachedScript(script, scriptLength);
+
+	if (sc == nullptr)
+	{
+		sc = std::shared_ptr<ExecutionScript>(new ExecutionScript(script, scriptLength));
+	}
+
 	Scripts.push_back(sc);
 
-	auto context = new ExecutionContext(sc, 0, rvcount);
-	this->InvocationStack.Push(context);
+	this->InvocationStack.Push(sc, 0, rvcount);
 	return index;
 }
 
@@ -145,6 +355,48 @@ void ExecutionEngine::StepInto()
 	}
 }
 
+template<bool(*Operation)(int64, int64&)>
+bool ExecutionEngine::TryInt64(ExecutionContext* context, IStackItem* &it)
+{
+	int64 value, result;
+
+	if (!StackItemConverter::GetInt64(it, value) || !Operation(value, result))
+	{
+		return false;
+	}
+
+	StackItemHelper::Free(it);
+
+	auto ret = this->CreateInteger(result);
+
+	if (ret != nullptr)
+	{
+		context->EvaluationStack.Push(ret);
+	}
+	return true;
+}
+
+template<bool(*Operation)(int64, int64, int64&)>
+bool ExecutionEngine::TryInt64(ExecutionContext* context, IStackItem* &i1, IStackItem* &i2)
+{
+	int64 value1, value2, result;
+
+	if (!StackItemConverter::GetInt64(i1, value1) || !StackItemConverter::GetInt64(i2, value2) || !Operation(value1, value2, result))
+	{
+		return false;
+	}
+
+	StackItemHelper::Free(i2, i1);
+
+	auto ret = this->CreateInteger(result);
+
+	if (ret != nullptr)
+	{
+		context->EvaluationStack.Push(ret);
+	}
+	return true;
+}
+
 void ExecutionEngine::InternalStepInto()
 {
 	auto context = this->InvocationStack.Top();
@@ -155,6 +407,26 @@ void ExecutionEngine::InternalStepInto()
 		return;
 	}
 
+	// Between instructions every live item is claimed by a stack, a compound item or the host
+
+	if (this->_counter->IsCollectionPending())
+	{
+		CycleCollector::Collect(this->_counter);
+	}
+
+	if (this->_counter->IsMemoryExceeded())
+	{
+		// Unreachable cycles could be holding it
+
+		CycleCollector::Collect(this->_counter);
+
+		if (this->_counter->IsMemoryExceeded())
+		{
+			this->_state = EVMState::FAULT_BY_MEMORY;
+			return;
+		}
+	}
+
 	if (this->Log != nullptr)
 	{
 		this->Log(context);
@@ -400,8 +672,7 @@ void ExecutionEngine::InternalStepInto()
 			return;
 		}
 
-		auto bi = new BigInteger(BigInteger::MinusOne);
-		auto ret = this->CreateInteger(bi);
+		auto ret = this->CreateInteger(-1);
 
 		if (ret != nullptr)
 		{
@@ -453,7 +724,7 @@ void ExecutionEngine::InternalStepInto()
 
 		auto it = context->EvaluationStack.Pop();
 
-		if ((opcode == EVMOpCode::JMPIF) == it->GetBoolean())
+		if ((opcode == EVMOpCode::JMPIF) == StackItemConverter::GetBoolean(it))
 		{
 			if (!context->SeekFromHere(offset - 3))
 			{
@@ -492,8 +763,7 @@ void ExecutionEngine::InternalStepInto()
 			return;
 		}
 
-		auto clone = context->Clone(-1, -1);
-		this->InvocationStack.Push(clone);
+		auto clone = this->InvocationStack.PushClone(context, -1, -1);
 		context->SeekFromHere(2);  // Official release don't check if is valid like JMP does
 
 		// Jump
@@ -529,8 +799,7 @@ void ExecutionEngine::InternalStepInto()
 			return;
 		}
 
-		auto clone = context->Clone(rvcount, pcount);
-		this->InvocationStack.Push(clone);
+		auto clone = this->InvocationStack.PushClone(context, rvcount, pcount);
 
 		context->SeekFromHere(2); // Official release don't check if is valid like JMP does
 
@@ -598,15 +867,16 @@ void ExecutionEngine::InternalStepInto()
 			// Get hash from the evaluation stack
 
 			auto it = context->EvaluationStack.Pop();
-			int32 size = it->ReadByteArraySize();
+			const byte* hash;
 
-			if (size != scriptLength || it->ReadByteArray(script_hash, 0, scriptLength) != scriptLength)
+			if (StackItemConverter::GetByteArrayView(it, hash) != scriptLength)
 			{
 				this->SetFault();
 				StackItemHelper::UnclaimAndFree(it);
 				return;
 			}
 
+			memcpy(script_hash, hash, scriptLength);
 			StackItemHelper::UnclaimAndFree(it);
 		}
 		else
@@ -642,8 +912,7 @@ void ExecutionEngine::InternalStepInto()
 
 		if (opcode == EVMOpCode::CALL_ET || opcode == EVMOpCode::CALL_EDT)
 		{
-			auto drop = this->InvocationStack.Pop(1);
-			if (drop != nullptr) drop->Clear();
+			this->InvocationStack.Recycle(this->InvocationStack.Pop(1));
 		}
 
 		return;
@@ -669,6 +938,7 @@ void ExecutionEngine::InternalStepInto()
 			{
 				if (rvcount > 0 && context->EvaluationStack.Count() < rvcount)
 				{
+					this->InvocationStack.Recycle(context);
 					this->SetFault();
 					return;
 				}
@@ -682,13 +952,23 @@ void ExecutionEngine::InternalStepInto()
 					context->EvaluationStack.SendTo(&this->GetCurrentContext()->EvaluationStack, rvcount);
 			}
 
-			// Clean remaning stack items from the counter
+			// Clean remaning stack items from the counter, and reuse the context
 
-			context->Clear();
+			this->InvocationStack.Recycle(context);
 		}
 
 		if (this->InvocationStack.Count() == 0)
 		{
+			// Entry context returned, nothing can reach the cycles left behind
+
+			CycleCollector::Collect(this->_counter);
+
+			if (this->_counter->IsMemoryExceeded())
+			{
+				this->_state = EVMState::FAULT_BY_MEMORY;
+				return;
+			}
+
 			this->SetHalt();
 		}
 
@@ -730,7 +1010,7 @@ void ExecutionEngine::InternalStepInto()
 			}
 
 			auto item = context->EvaluationStack.Pop();
-			if (item->ReadByteArray(&script_hash[0], 0, scriptLength) != scriptLength)
+			if (StackItemConverter::ReadByteArray(item, &script_hash[0], 0, scriptLength) != scriptLength)
 			{
 				StackItemHelper::Free(item);
 				this->SetFault();
@@ -771,8 +1051,7 @@ void ExecutionEngine::InternalStepInto()
 
 		if (opcode == EVMOpCode::TAILCALL)
 		{
-			auto drop = this->InvocationStack.Pop(1);
-			if (drop != nullptr) drop->Clear();
+			this->InvocationStack.Recycle(this->InvocationStack.Pop(1));
 		}
 
 		return;
@@ -877,7 +1156,7 @@ void ExecutionEngine::InternalStepInto()
 		auto it = context->EvaluationStack.Pop();
 
 		int32 n = 0;
-		if (!it->GetInt32(n) || n < 0 || n >= ic - 1)
+		if (!StackItemConverter::GetInt32(it, n) || n < 0 || n >= ic - 1)
 		{
 			StackItemHelper::Free(it);
 			this->SetFault();
@@ -906,7 +1185,7 @@ void ExecutionEngine::InternalStepInto()
 		int32 n = 0;
 		auto it = context->EvaluationStack.Pop();
 
-		if (!it->GetInt32(n) || n < 0 || n >= ic - 1)
+		if (!StackItemConverter::GetInt32(it, n) || n < 0 || n >= ic - 1)
 		{
 			StackItemHelper::Free(it);
 			this->SetFault();
@@ -941,7 +1220,7 @@ void ExecutionEngine::InternalStepInto()
 		int32 n = 0;
 		auto it = context->EvaluationStack.Pop();
 
-		if (!it->GetInt32(n) || n <= 0 || n > ic - 1)
+		if (!StackItemConverter::GetInt32(it, n) || n <= 0 || n > ic - 1)
 		{
 			StackItemHelper::Free(it);
 			this->SetFault();
@@ -1050,7 +1329,7 @@ void ExecutionEngine::InternalStepInto()
 		int32 n = 0;
 		auto it = context->EvaluationStack.Pop();
 
-		if (!it->GetInt32(n) || n < 0)
+		if (!StackItemConverter::GetInt32(it, n) || n < 0)
 		{
 			StackItemHelper::Free(it);
 			this->SetFault();
@@ -1085,7 +1364,7 @@ void ExecutionEngine::InternalStepInto()
 		int32 n = 0;
 		auto it = context->EvaluationStack.Pop();
 
-		if (!it->GetInt32(n) || n < 0)
+		if (!StackItemConverter::GetInt32(it, n) || n < 0)
 		{
 			StackItemHelper::Free(it);
 			this->SetFault();
@@ -1171,8 +1450,11 @@ void ExecutionEngine::InternalStepInto()
 
 		auto x2 = context->EvaluationStack.Pop();
 		auto x1 = context->EvaluationStack.Pop();
-		int32 size2 = x2->ReadByteArraySize();
-		int32 size1 = x1->ReadByteArraySize();
+
+		const byte* data2;
+		const byte* data1;
+		int32 size2 = StackItemConverter::GetByteArrayView(x2, data2);
+		int32 size1 = StackItemConverter::GetByteArrayView(x1, data1);
 
 		if (size2 < 0 || size1 < 0 || size1 + size2 > MAX_ITEM_LENGTH)
 		{
@@ -1183,8 +1465,8 @@ void ExecutionEngine::InternalStepInto()
 		}
 
 		byte* data = new byte[size2 + size1];
-		x1->ReadByteArray(&data[0], 0, size1);
-		x2->ReadByteArray(&data[size1], 0, size2);
+		if (size1 > 0) memcpy(&data[0], data1, size1);
+		if (size2 > 0) memcpy(&data[size1], data2, size2);
 
 		StackItemHelper::Free(x2, x1);
 
@@ -1212,7 +1494,7 @@ void ExecutionEngine::InternalStepInto()
 		int32 count = 0;
 		auto it = context->EvaluationStack.Pop();
 
-		if (!it->GetInt32(count) || count < 0)
+		if (!StackItemConverter::GetInt32(it, count) || count < 0)
 		{
 			StackItemHelper::Free(it);
 			this->SetFault();
@@ -1223,7 +1505,7 @@ void ExecutionEngine::InternalStepInto()
 		it = context->EvaluationStack.Pop();
 		int32 index = 0;
 
-		if (!it->GetInt32(index) || index < 0)
+		if (!StackItemConverter::GetInt32(it, index) || index < 0)
 		{
 			StackItemHelper::Free(it);
 			this->SetFault();
@@ -1234,7 +1516,7 @@ void ExecutionEngine::InternalStepInto()
 		it = context->EvaluationStack.Pop();
 
 		byte* data = new byte[count];
-		if (it->ReadByteArray(&data[0], index, count) != count)
+		if (StackItemConverter::ReadByteArray(it, &data[0], index, count) != count)
 		{
 			delete[]data;
 			StackItemHelper::Free(it);
@@ -1267,7 +1549,7 @@ void ExecutionEngine::InternalStepInto()
 		int32 count = 0;
 		auto it = context->EvaluationStack.Pop();
 
-		if (!it->GetInt32(count) || count < 0)
+		if (!StackItemConverter::GetInt32(it, count) || count < 0)
 		{
 			StackItemHelper::Free(it);
 			this->SetFault();
@@ -1278,7 +1560,7 @@ void ExecutionEngine::InternalStepInto()
 		it = context->EvaluationStack.Pop();
 
 		byte* data = new byte[count];
-		if (it->ReadByteArray(&data[0], 0, count) != count)
+		if (StackItemConverter::ReadByteArray(it, &data[0], 0, count) != count)
 		{
 			delete[]data;
 			StackItemHelper::Free(it);
@@ -1311,7 +1593,7 @@ void ExecutionEngine::InternalStepInto()
 		int32 count = 0;
 		auto it = context->EvaluationStack.Pop();
 
-		if (!it->GetInt32(count) || count < 0)
+		if (!StackItemConverter::GetInt32(it, count) || count < 0)
 		{
 			StackItemHelper::Free(it);
 			this->SetFault();
@@ -1322,7 +1604,7 @@ void ExecutionEngine::InternalStepInto()
 		it = context->EvaluationStack.Pop();
 
 		byte* data = new byte[count];
-		if (it->ReadByteArray(&data[0], it->ReadByteArraySize() - count, count) != count)
+		if (StackItemConverter::ReadByteArray(it, &data[0], StackItemConverter::ReadByteArraySize(it) - count, count) != count)
 		{
 			delete[]data;
 			StackItemHelper::Free(it);
@@ -1353,7 +1635,7 @@ void ExecutionEngine::InternalStepInto()
 		}
 
 		auto it = context->EvaluationStack.Pop();
-		int32 size = it->ReadByteArraySize();
+		int32 size = StackItemConverter::ReadByteArraySize(it);
 		StackItemHelper::Free(it);
 
 		if (size < 0)
@@ -1386,25 +1668,38 @@ void ExecutionEngine::InternalStepInto()
 		}
 
 		auto it = context->EvaluationStack.Pop();
-		auto bi = it->GetBigInteger();
-		StackItemHelper::Free(it);
 
-		if (bi == nullptr)
+		int64 value;
+		if (StackItemConverter::GetSmallInt64(it, value))
 		{
-			this->SetFault();
+			StackItemHelper::Free(it);
+
+			auto ret = this->CreateInteger(~value);
+
+			if (ret != nullptr)
+			{
+				context->EvaluationStack.Push(ret);
+			}
 			return;
 		}
 
-		auto reti = bi->Invert();
-		delete(bi);
+		// On the encoding, without decoding the operand
 
-		if (reti == nullptr)
+		const byte* data;
+		int32 size = StackItemConverter::GetByteArrayView(it, data);
+
+		if (size < 0)
 		{
+			StackItemHelper::Free(it);
 			this->SetFault();
 			return;
 		}
 
-		auto ret = this->CreateInteger(reti);
+		ScratchBuffer<byte, MAX_BIGINTEGER_SIZE> reti(size > 0 ? size : 1);
+		ByteKernel::Invert(data, size, reti);
+		StackItemHelper::Free(it);
+
+		auto ret = this->CreateInteger(reti, size > 0 ? size : 1);
 
 		if (ret != nullptr)
 		{
@@ -1428,32 +1723,40 @@ void ExecutionEngine::InternalStepInto()
 		auto x2 = context->EvaluationStack.Pop();
 		auto x1 = context->EvaluationStack.Pop();
 
-		auto i2 = x2->GetBigInteger();
-		auto i1 = x1->GetBigInteger();
-
-		StackItemHelper::Free(x1, x2);
-
-		if (i2 == nullptr || i1 == nullptr)
+		int64 value1, value2;
+		if (StackItemConverter::GetSmallInt64(x1, value1) && StackItemConverter::GetSmallInt64(x2, value2))
 		{
-			if (i2 != nullptr) delete(i2);
-			if (i1 != nullptr) delete(i1);
+			StackItemHelper::Free(x1, x2);
 
-			this->SetFault();
+			auto ret = this->CreateInteger(value1 & value2);
+
+			if (ret != nullptr)
+			{
+				context->EvaluationStack.Push(ret);
+			}
 			return;
 		}
 
-		auto reti = i1->And(i2);
+		// On the encodings, without decoding the operands
 
-		delete(i2);
-		delete(i1);
+		const byte* data2;
+		const byte* data1;
+		int32 size2 = StackItemConverter::GetByteArrayView(x2, data2);
+		int32 size1 = StackItemConverter::GetByteArrayView(x1, data1);
 
-		if (reti == nullptr)
+		if (size2 < 0 || size1 < 0)
 		{
+			StackItemHelper::Free(x1, x2);
 			this->SetFault();
 			return;
 		}
 
-		auto ret = this->CreateInteger(reti);
+		int32 size = size1 > size2 ? size1 : size2;
+		ScratchBuffer<byte, MAX_BIGINTEGER_SIZE> reti(size);
+		ByteKernel::And(data1, size1, data2, size2, reti);
+		StackItemHelper::Free(x1, x2);
+
+		auto ret = this->CreateInteger(reti, size);
 
 		if (ret != nullptr)
 		{
@@ -1477,32 +1780,40 @@ void ExecutionEngine::InternalStepInto()
 		auto x2 = context->EvaluationStack.Pop();
 		auto x1 = context->EvaluationStack.Pop();
 
-		auto i2 = x2->GetBigInteger();
-		auto i1 = x1->GetBigInteger();
-
-		StackItemHelper::Free(x1, x2);
-
-		if (i2 == nullptr || i1 == nullptr)
+		int64 value1, value2;
+		if (StackItemConverter::GetSmallInt64(x1, value1) && StackItemConverter::GetSmallInt64(x2, value2))
 		{
-			if (i2 != nullptr) delete(i2);
-			if (i1 != nullptr) delete(i1);
+			StackItemHelper::Free(x1, x2);
 
-			this->SetFault();
+			auto ret = this->CreateInteger(value1 | value2);
+
+			if (ret != nullptr)
+			{
+				context->EvaluationStack.Push(ret);
+			}
 			return;
 		}
 
-		auto reti = i1->Or(i2);
+		// On the encodings, without decoding the operands
 
-		delete(i2);
-		delete(i1);
+		const byte* data2;
+		const byte* data1;
+		int32 size2 = StackItemConverter::GetByteArrayView(x2, data2);
+		int32 size1 = StackItemConverter::GetByteArrayView(x1, data1);
 
-		if (reti == nullptr)
+		if (size2 < 0 || size1 < 0)
 		{
+			StackItemHelper::Free(x1, x2);
 			this->SetFault();
 			return;
 		}
 
-		auto ret = this->CreateInteger(reti);
+		int32 size = size1 > size2 ? size1 : size2;
+		ScratchBuffer<byte, MAX_BIGINTEGER_SIZE> reti(size);
+		ByteKernel::Or(data1, size1, data2, size2, reti);
+		StackItemHelper::Free(x1, x2);
+
+		auto ret = this->CreateInteger(reti, size);
 
 		if (ret != nullptr)
 		{
@@ -1526,32 +1837,40 @@ void ExecutionEngine::InternalStepInto()
 		auto x2 = context->EvaluationStack.Pop();
 		auto x1 = context->EvaluationStack.Pop();
 
-		auto i2 = x2->GetBigInteger();
-		auto i1 = x1->GetBigInteger();
-
-		StackItemHelper::Free(x1, x2);
-
-		if (i2 == nullptr || i1 == nullptr)
+		int64 value1, value2;
+		if (StackItemConverter::GetSmallInt64(x1, value1) && StackItemConverter::GetSmallInt64(x2, value2))
 		{
-			if (i2 != nullptr) delete(i2);
-			if (i1 != nullptr) delete(i1);
+			StackItemHelper::Free(x1, x2);
 
-			this->SetFault();
+			auto ret = this->CreateInteger(value1 ^ value2);
+
+			if (ret != nullptr)
+			{
+				context->EvaluationStack.Push(ret);
+			}
 			return;
 		}
 
-		auto reti = i1->Xor(i2);
+		// On the encodings, without decoding the operands
 
-		delete(i2);
-		delete(i1);
+		const byte* data2;
+		const byte* data1;
+		int32 size2 = StackItemConverter::GetByteArrayView(x2, data2);
+		int32 size1 = StackItemConverter::GetByteArrayView(x1, data1);
 
-		if (reti == nullptr)
+		if (size2 < 0 || size1 < 0)
 		{
+			StackItemHelper::Free(x1, x2);
 			this->SetFault();
 			return;
 		}
 
-		auto ret = this->CreateInteger(reti);
+		int32 size = size1 > size2 ? size1 : size2;
+		ScratchBuffer<byte, MAX_BIGINTEGER_SIZE> reti(size);
+		ByteKernel::Xor(data1, size1, data2, size2, reti);
+		StackItemHelper::Free(x1, x2);
+
+		auto ret = this->CreateInteger(reti, size);
 
 		if (ret != nullptr)
 		{
@@ -1574,7 +1893,7 @@ void ExecutionEngine::InternalStepInto()
 
 		auto x2 = context->EvaluationStack.Pop();
 		auto x1 = context->EvaluationStack.Pop();
-		auto ret = this->CreateBool(x1->Equals(x2));
+		auto ret = this->CreateBool(StackItemConverter::Equals(x1, x2));
 		StackItemHelper::Free(x2, x1);
 
 		if (ret != nullptr)
@@ -1600,36 +1919,27 @@ void ExecutionEngine::InternalStepInto()
 		}
 
 		auto it = context->EvaluationStack.Pop();
-		auto bi = it->GetBigInteger();
-		StackItemHelper::Free(it);
 
-		if (bi == nullptr)
+		if (this->TryInt64<CheckedMath::Inc>(context, it))
 		{
-			this->SetFault();
 			return;
 		}
 
-		if (bi->SizeExceeded())
-		{
-			delete(bi);
-			this->SetFault();
-			return;
-		}
+		BigInteger temp, reti;
+		auto bi = StackItemConverter::GetBigInteger(it, temp);
 
-		auto add = new BigInteger(BigInteger::One);
-		auto reti = bi->Add(add);
-		delete(add);
-		delete(bi);
-
-		if (reti == nullptr)
+		if (bi == nullptr || bi->SizeExceeded())
 		{
+			StackItemHelper::Free(it);
 			this->SetFault();
 			return;
 		}
 
-		if (reti->SizeExceeded())
+		bi->Add(BigInteger::One, reti);
+		StackItemHelper::Free(it);
+
+		if (reti.SizeExceeded())
 		{
-			delete(reti);
 			this->SetFault();
 			return;
 		}
@@ -1656,36 +1966,27 @@ void ExecutionEngine::InternalStepInto()
 		}
 
 		auto it = context->EvaluationStack.Pop();
-		auto bi = it->GetBigInteger();
-		StackItemHelper::Free(it);
-
-		if (bi == nullptr)
-		{
-			this->SetFault();
-			return;
-		}
 
-		if (bi->SizeExceeded())
+		if (this->TryInt64<CheckedMath::Dec>(context, it))
 		{
-			delete(bi);
-			this->SetFault();
 			return;
 		}
 
-		auto add = new BigInteger(BigInteger::One);
-		auto reti = bi->Sub(add);
-		delete(add);
-		delete(bi);
+		BigInteger temp, reti;
+		auto bi = StackItemConverter::GetBigInteger(it, temp);
 
-		if (reti == nullptr)
+		if (bi == nullptr || bi->SizeExceeded())
 		{
+			StackItemHelper::Free(it);
 			this->SetFault();
 			return;
 		}
 
-		if (reti->SizeExceeded())
+		bi->Sub(BigInteger::One, reti);
+		StackItemHelper::Free(it);
+
+		if (reti.SizeExceeded())
 		{
-			delete(reti);
 			this->SetFault();
 			return;
 		}
@@ -1712,17 +2013,19 @@ void ExecutionEngine::InternalStepInto()
 		}
 
 		auto it = context->EvaluationStack.Pop();
-		auto bi = it->GetBigInteger();
-		StackItemHelper::Free(it);
+
+		BigInteger temp;
+		auto bi = StackItemConverter::GetBigInteger(it, temp);
 
 		if (bi == nullptr)
 		{
+			StackItemHelper::Free(it);
 			this->SetFault();
 			return;
 		}
 
 		int32 reti = bi->GetSign();
-		delete(bi);
+		StackItemHelper::Free(it);
 
 		auto ret = this->CreateInteger(reti);
 
@@ -1746,24 +2049,25 @@ void ExecutionEngine::InternalStepInto()
 		}
 
 		auto it = context->EvaluationStack.Pop();
-		auto bi = it->GetBigInteger();
-		StackItemHelper::Free(it);
 
-		if (bi == nullptr)
+		if (this->TryInt64<CheckedMath::Negate>(context, it))
 		{
-			this->SetFault();
 			return;
 		}
 
-		auto reti = bi->Negate();
-		delete(bi);
+		BigInteger temp, reti;
+		auto bi = StackItemConverter::GetBigInteger(it, temp);
 
-		if (reti == nullptr)
+		if (bi == nullptr)
 		{
+			StackItemHelper::Free(it);
 			this->SetFault();
 			return;
 		}
 
+		bi->Negate(reti);
+		StackItemHelper::Free(it);
+
 		auto ret = this->CreateInteger(reti);
 
 		if (ret != nullptr)
@@ -1786,24 +2090,25 @@ void ExecutionEngine::InternalStepInto()
 		}
 
 		auto it = context->EvaluationStack.Pop();
-		auto bi = it->GetBigInteger();
-		StackItemHelper::Free(it);
 
-		if (bi == nullptr)
+		if (this->TryInt64<CheckedMath::Abs>(context, it))
 		{
-			this->SetFault();
 			return;
 		}
 
-		auto reti = bi->Abs();
-		delete(bi);
+		BigInteger temp, reti;
+		auto bi = StackItemConverter::GetBigInteger(it, temp);
 
-		if (reti == nullptr)
+		if (bi == nullptr)
 		{
+			StackItemHelper::Free(it);
 			this->SetFault();
 			return;
 		}
 
+		bi->Abs(reti);
+		StackItemHelper::Free(it);
+
 		auto ret = this->CreateInteger(reti);
 
 		if (ret != nullptr)
@@ -1826,7 +2131,7 @@ void ExecutionEngine::InternalStepInto()
 		}
 
 		auto it = context->EvaluationStack.Pop();
-		auto ret = this->CreateBool(!it->GetBoolean());
+		auto ret = this->CreateBool(!StackItemConverter::GetBoolean(it));
 		StackItemHelper::Free(it);
 
 		if (ret != nullptr)
@@ -1850,17 +2155,21 @@ void ExecutionEngine::InternalStepInto()
 		}
 
 		auto x = context->EvaluationStack.Pop();
-		auto i = x->GetBigInteger();
-		StackItemHelper::Free(x);
+
+		BigInteger temp;
+		auto i = StackItemConverter::GetBigInteger(x, temp);
 
 		if (i == nullptr)
 		{
+			StackItemHelper::Free(x);
 			this->SetFault();
 			return;
 		}
 
-		auto ret = this->CreateBool(i->CompareTo(BigInteger::Zero) != 0);
-		delete(i);
+		bool nz = i->CompareTo(BigInteger::Zero) != 0;
+		StackItemHelper::Free(x);
+
+		auto ret = this->CreateBool(nz);
 
 		if (ret != nullptr)
 		{
@@ -1884,34 +2193,30 @@ void ExecutionEngine::InternalStepInto()
 
 		auto i2 = context->EvaluationStack.Pop();
 		auto i1 = context->EvaluationStack.Pop();
-		auto x2 = i2->GetBigInteger();
-		auto x1 = i1->GetBigInteger();
-		StackItemHelper::Free(i2, i1);
 
-		if (x2 == nullptr || x1 == nullptr ||
-			x2->SizeExceeded() ||
-			x1->SizeExceeded())
+		if (this->TryInt64<CheckedMath::Add>(context, i1, i2))
 		{
-			if (x2 != nullptr) delete(x2);
-			if (x1 != nullptr) delete(x1);
-
-			this->SetFault();
 			return;
 		}
 
-		auto reti = x1->Add(x2);
-		delete(x2);
-		delete(x1);
+		BigInteger temp2, temp1, reti;
+		auto x2 = StackItemConverter::GetBigInteger(i2, temp2);
+		auto x1 = StackItemConverter::GetBigInteger(i1, temp1);
 
-		if (reti == nullptr)
+		if (x2 == nullptr || x1 == nullptr ||
+			x2->SizeExceeded() ||
+			x1->SizeExceeded())
 		{
+			StackItemHelper::Free(i2, i1);
 			this->SetFault();
 			return;
 		}
 
-		if (reti->SizeExceeded())
+		x1->Add(*x2, reti);
+		StackItemHelper::Free(i2, i1);
+
+		if (reti.SizeExceeded())
 		{
-			delete(reti);
 			this->SetFault();
 			return;
 		}
@@ -1939,34 +2244,30 @@ void ExecutionEngine::InternalStepInto()
 
 		auto i2 = context->EvaluationStack.Pop();
 		auto i1 = context->EvaluationStack.Pop();
-		auto x2 = i2->GetBigInteger();
-		auto x1 = i1->GetBigInteger();
-		StackItemHelper::Free(i2, i1);
 
-		if (x2 == nullptr || x1 == nullptr ||
-			x2->SizeExceeded() ||
-			x1->SizeExceeded())
+		if (this->TryInt64<CheckedMath::Sub>(context, i1, i2))
 		{
-			if (x2 != nullptr) delete(x2);
-			if (x1 != nullptr) delete(x1);
-
-			this->SetFault();
 			return;
 		}
 
-		auto reti = x1->Sub(x2);
-		delete(x2);
-		delete(x1);
+		BigInteger temp2, temp1, reti;
+		auto x2 = StackItemConverter::GetBigInteger(i2, temp2);
+		auto x1 = StackItemConverter::GetBigInteger(i1, temp1);
 
-		if (reti == nullptr)
+		if (x2 == nullptr || x1 == nullptr ||
+			x2->SizeExceeded() ||
+			x1->SizeExceeded())
 		{
+			StackItemHelper::Free(i2, i1);
 			this->SetFault();
 			return;
 		}
 
-		if (reti->SizeExceeded())
+		x1->Sub(*x2, reti);
+		StackItemHelper::Free(i2, i1);
+
+		if (reti.SizeExceeded())
 		{
-			delete(reti);
 			this->SetFault();
 			return;
 		}
@@ -1994,32 +2295,29 @@ void ExecutionEngine::InternalStepInto()
 
 		auto i2 = context->EvaluationStack.Pop();
 		auto i1 = context->EvaluationStack.Pop();
-		auto x2 = i2->GetBigInteger();
-		auto x1 = i1->GetBigInteger();
-		StackItemHelper::Free(i2, i1);
 
-		if (
-			x2 == nullptr || x1 == nullptr ||
-			x2->ToByteArraySize() + x1->ToByteArraySize() > MAX_BIGINTEGER_SIZE
-			)
+		if (this->TryInt64<CheckedMath::Mul>(context, i1, i2))
 		{
-			if (x2 != nullptr) delete(x2);
-			if (x1 != nullptr) delete(x1);
-
-			this->SetFault();
 			return;
 		}
 
-		auto reti = x1->Mul(x2);
-		delete(x2);
-		delete(x1);
+		BigInteger temp2, temp1, reti;
+		auto x2 = StackItemConverter::GetBigInteger(i2, temp2);
+		auto x1 = StackItemConverter::GetBigInteger(i1, temp1);
 
-		if (reti == nullptr)
+		if (
+			x2 == nullptr || x1 == nullptr ||
+			x2->ToByteArraySize() + x1->ToByteArraySize() > MAX_BIGINTEGER_SIZE
+			)
 		{
+			StackItemHelper::Free(i2, i1);
 			this->SetFault();
 			return;
 		}
 
+		x1->Mul(*x2, reti);
+		StackItemHelper::Free(i2, i1);
+
 		auto ret = this->CreateInteger(reti);
 
 		if (ret != nullptr)
@@ -2043,26 +2341,23 @@ void ExecutionEngine::InternalStepInto()
 
 		auto i2 = context->EvaluationStack.Pop();
 		auto i1 = context->EvaluationStack.Pop();
-		auto x2 = i2->GetBigInteger();
-		auto x1 = i1->GetBigInteger();
-		StackItemHelper::Free(i2, i1);
+		BigInteger temp2, temp1, reti;
+		auto x2 = StackItemConverter::GetBigInteger(i2, temp2);
+		auto x1 = StackItemConverter::GetBigInteger(i1, temp1);
 
 		if (x2 == nullptr || x1 == nullptr ||
 			x1->SizeExceeded() ||
 			x2->SizeExceeded())
 		{
-			if (x2 != nullptr) delete(x2);
-			if (x1 != nullptr) delete(x1);
-
+			StackItemHelper::Free(i2, i1);
 			this->SetFault();
 			return;
 		}
 
-		auto reti = x1->Div(x2);
-		delete(x2);
-		delete(x1);
+		bool done = x1->Div(*x2, reti);
+		StackItemHelper::Free(i2, i1);
 
-		if (reti == nullptr)
+		if (!done)
 		{
 			this->SetFault();
 			return;
@@ -2091,26 +2386,23 @@ void ExecutionEngine::InternalStepInto()
 
 		auto i2 = context->EvaluationStack.Pop();
 		auto i1 = context->EvaluationStack.Pop();
-		auto x2 = i2->GetBigInteger();
-		auto x1 = i1->GetBigInteger();
-		StackItemHelper::Free(i2, i1);
+		BigInteger temp2, temp1, reti;
+		auto x2 = StackItemConverter::GetBigInteger(i2, temp2);
+		auto x1 = StackItemConverter::GetBigInteger(i1, temp1);
 
 		if (x2 == nullptr || x1 == nullptr ||
 			x1->SizeExceeded() ||
 			x2->SizeExceeded())
 		{
-			if (x2 != nullptr) delete(x2);
-			if (x1 != nullptr) delete(x1);
-
+			StackItemHelper::Free(i2, i1);
 			this->SetFault();
 			return;
 		}
 
-		auto reti = x1->Mod(x2);
-		delete(x2);
-		delete(x1);
+		bool done = x1->Mod(*x2, reti);
+		StackItemHelper::Free(i2, i1);
 
-		if (reti == nullptr)
+		if (!done)
 		{
 			this->SetFault();
 			return;
@@ -2139,34 +2431,34 @@ void ExecutionEngine::InternalStepInto()
 
 		auto n = context->EvaluationStack.Pop();
 		auto x = context->EvaluationStack.Pop();
-		auto in = n->GetBigInteger();
-		auto ix = x->GetBigInteger();
-
-		StackItemHelper::Free(n, x);
+		BigInteger tempn, tempx, reti;
+		auto in = StackItemConverter::GetBigInteger(n, tempn);
+		auto ix = StackItemConverter::GetBigInteger(x, tempx);
 
 		int32 ishift;
 		if (in == nullptr || ix == nullptr || !in->ToInt32(ishift) || (ishift > MAX_SHL_SHR || ishift < MIN_SHL_SHR))
 		{
-			if (ix != nullptr) delete(ix);
-			if (in != nullptr) delete(in);
-
+			StackItemHelper::Free(n, x);
 			this->SetFault();
 			return;
 		}
 
-		delete(in);
-		auto reti = ix->Shl(ishift);
-		delete(ix);
+		// The magnitude grows by the left shift, when it can't fit fault before the work
+
+		int32 grow = ishift > 0 ? ishift : 0;
 
-		if (reti == nullptr)
+		if (grow > 0 && ix->GetSign() != 0 && ix->GetBitLength() + grow > MAX_BIGINTEGER_SIZE * 8)
 		{
+			StackItemHelper::Free(n, x);
 			this->SetFault();
 			return;
 		}
 
-		if (reti->SizeExceeded())
+		ix->Shl(ishift, reti);
+		StackItemHelper::Free(n, x);
+
+		if (reti.SizeExceeded())
 		{
-			delete(reti);
 			this->SetFault();
 			return;
 		}
@@ -2194,34 +2486,34 @@ void ExecutionEngine::InternalStepInto()
 
 		auto n = context->EvaluationStack.Pop();
 		auto x = context->EvaluationStack.Pop();
-		auto in = n->GetBigInteger();
-		auto ix = x->GetBigInteger();
-
-		StackItemHelper::Free(n, x);
+		BigInteger tempn, tempx, reti;
+		auto in = StackItemConverter::GetBigInteger(n, tempn);
+		auto ix = StackItemConverter::GetBigInteger(x, tempx);
 
 		int32 ishift;
 		if (in == nullptr || ix == nullptr || !in->ToInt32(ishift) || (ishift > MAX_SHL_SHR || ishift < MIN_SHL_SHR))
 		{
-			if (ix != nullptr) delete(ix);
-			if (in != nullptr) delete(in);
-
+			StackItemHelper::Free(n, x);
 			this->SetFault();
 			return;
 		}
 
-		delete(in);
-		auto reti = ix->Shr(ishift);
-		delete(ix);
+		// The magnitude grows by the left shift, when it can't fit fault before the work
 
-		if (reti == nullptr)
+		int32 grow = ishift < 0 ? -ishift : 0;
+
+		if (grow > 0 && ix->GetSign() != 0 && ix->GetBitLength() + grow > MAX_BIGINTEGER_SIZE * 8)
 		{
+			StackItemHelper::Free(n, x);
 			this->SetFault();
 			return;
 		}
 
-		if (reti->SizeExceeded())
+		ix->Shr(ishift, reti);
+		StackItemHelper::Free(n, x);
+
+		if (reti.SizeExceeded())
 		{
-			delete(reti);
 			this->SetFault();
 			return;
 		}
@@ -2249,7 +2541,7 @@ void ExecutionEngine::InternalStepInto()
 
 		auto x2 = context->EvaluationStack.Pop();
 		auto x1 = context->EvaluationStack.Pop();
-		auto ret = this->CreateBool(x1->GetBoolean() && x2->GetBoolean());
+		auto ret = this->CreateBool(StackItemConverter::GetBoolean(x1) && StackItemConverter::GetBoolean(x2));
 		StackItemHelper::Free(x2, x1);
 
 		if (ret != nullptr)
@@ -2273,7 +2565,7 @@ void ExecutionEngine::InternalStepInto()
 
 		auto x2 = context->EvaluationStack.Pop();
 		auto x1 = context->EvaluationStack.Pop();
-		auto ret = this->CreateBool(x1->GetBoolean() || x2->GetBoolean());
+		auto ret = this->CreateBool(StackItemConverter::GetBoolean(x1) || StackItemConverter::GetBoolean(x2));
 		StackItemHelper::Free(x2, x1);
 
 		if (ret != nullptr)
@@ -2298,24 +2590,17 @@ void ExecutionEngine::InternalStepInto()
 		auto x2 = context->EvaluationStack.Pop();
 		auto x1 = context->EvaluationStack.Pop();
 
-		auto i2 = x2->GetBigInteger();
-		auto i1 = x1->GetBigInteger();
-
+		int32 cmp;
+		bool ok = StackItemConverter::CompareTo(x1, x2, cmp);
 		StackItemHelper::Free(x1, x2);
 
-		if (i2 == nullptr || i1 == nullptr)
+		if (!ok)
 		{
-			if (i2 != nullptr) delete(i2);
-			if (i1 != nullptr) delete(i1);
-
 			this->SetFault();
 			return;
 		}
 
-		auto ret = this->CreateBool(i1->CompareTo(i2) == 0);
-
-		delete(i2);
-		delete(i1);
+		auto ret = this->CreateBool(cmp == 0);
 
 		if (ret != nullptr)
 		{
@@ -2339,24 +2624,17 @@ void ExecutionEngine::InternalStepInto()
 		auto x2 = context->EvaluationStack.Pop();
 		auto x1 = context->EvaluationStack.Pop();
 
-		auto i2 = x2->GetBigInteger();
-		auto i1 = x1->GetBigInteger();
-
+		int32 cmp;
+		bool ok = StackItemConverter::CompareTo(x1, x2, cmp);
 		StackItemHelper::Free(x1, x2);
 
-		if (i2 == nullptr || i1 == nullptr)
+		if (!ok)
 		{
-			if (i2 != nullptr) delete(i2);
-			if (i1 != nullptr) delete(i1);
-
 			this->SetFault();
 			return;
 		}
 
-		auto ret = this->CreateBool(i1->CompareTo(i2) != 0);
-
-		delete(i2);
-		delete(i1);
+		auto ret = this->CreateBool(cmp != 0);
 
 		if (ret != nullptr)
 		{
@@ -2380,24 +2658,17 @@ void ExecutionEngine::InternalStepInto()
 		auto x2 = context->EvaluationStack.Pop();
 		auto x1 = context->EvaluationStack.Pop();
 
-		auto i2 = x2->GetBigInteger();
-		auto i1 = x1->GetBigInteger();
-
+		int32 cmp;
+		bool ok = StackItemConverter::CompareTo(x1, x2, cmp);
 		StackItemHelper::Free(x1, x2);
 
-		if (i2 == nullptr || i1 == nullptr)
+		if (!ok)
 		{
-			if (i2 != nullptr) delete(i2);
-			if (i1 != nullptr) delete(i1);
-
 			this->SetFault();
 			return;
 		}
 
-		auto ret = this->CreateBool(i1->CompareTo(i2) < 0);
-
-		delete(i1);
-		delete(i2);
+		auto ret = this->CreateBool(cmp < 0);
 
 		if (ret != nullptr)
 		{
@@ -2421,24 +2692,17 @@ void ExecutionEngine::InternalStepInto()
 		auto x2 = context->EvaluationStack.Pop();
 		auto x1 = context->EvaluationStack.Pop();
 
-		auto i2 = x2->GetBigInteger();
-		auto i1 = x1->GetBigInteger();
-
+		int32 cmp;
+		bool ok = StackItemConverter::CompareTo(x1, x2, cmp);
 		StackItemHelper::Free(x1, x2);
 
-		if (i2 == nullptr || i1 == nullptr)
+		if (!ok)
 		{
-			if (i2 != nullptr) delete(i2);
-			if (i1 != nullptr) delete(i1);
-
 			this->SetFault();
 			return;
 		}
 
-		auto ret = this->CreateBool(i1->CompareTo(i2) > 0);
-
-		delete(i2);
-		delete(i1);
+		auto ret = this->CreateBool(cmp > 0);
 
 		if (ret != nullptr)
 		{
@@ -2462,24 +2726,17 @@ void ExecutionEngine::InternalStepInto()
 		auto x2 = context->EvaluationStack.Pop();
 		auto x1 = context->EvaluationStack.Pop();
 
-		auto i2 = x2->GetBigInteger();
-		auto i1 = x1->GetBigInteger();
-
+		int32 cmp;
+		bool ok = StackItemConverter::CompareTo(x1, x2, cmp);
 		StackItemHelper::Free(x1, x2);
 
-		if (i2 == nullptr || i1 == nullptr)
+		if (!ok)
 		{
-			if (i2 != nullptr) delete(i2);
-			if (i1 != nullptr) delete(i1);
-
 			this->SetFault();
 			return;
 		}
 
-		auto ret = this->CreateBool(i1->CompareTo(i2) <= 0);
-
-		delete(i2);
-		delete(i1);
+		auto ret = this->CreateBool(cmp <= 0);
 
 		if (ret != nullptr)
 		{
@@ -2503,24 +2760,17 @@ void ExecutionEngine::InternalStepInto()
 		auto x2 = context->EvaluationStack.Pop();
 		auto x1 = context->EvaluationStack.Pop();
 
-		auto i2 = x2->GetBigInteger();
-		auto i1 = x1->GetBigInteger();
-
+		int32 cmp;
+		bool ok = StackItemConverter::CompareTo(x1, x2, cmp);
 		StackItemHelper::Free(x1, x2);
 
-		if (i2 == nullptr || i1 == nullptr)
+		if (!ok)
 		{
-			if (i2 != nullptr) delete(i2);
-			if (i1 != nullptr) delete(i1);
-
 			this->SetFault();
 			return;
 		}
 
-		auto ret = this->CreateBool(i1->CompareTo(i2) >= 0);
-
-		delete(i2);
-		delete(i1);
+		auto ret = this->CreateBool(cmp >= 0);
 
 		if (ret != nullptr)
 		{
@@ -2544,31 +2794,27 @@ void ExecutionEngine::InternalStepInto()
 		auto x2 = context->EvaluationStack.Pop();
 		auto x1 = context->EvaluationStack.Pop();
 
-		auto i2 = x2->GetBigInteger();
-		auto i1 = x1->GetBigInteger();
+		if (this->TryInt64<CheckedMath::Min>(context, x1, x2))
+		{
+			return;
+		}
 
-		StackItemHelper::Free(x1, x2);
+		int32 cmp;
 
-		if (i2 == nullptr || i1 == nullptr)
+		if (!StackItemConverter::CompareTo(x1, x2, cmp))
 		{
-			if (i2 != nullptr) delete(i2);
-			if (i1 != nullptr) delete(i1);
-
+			StackItemHelper::Free(x1, x2);
 			this->SetFault();
 			return;
 		}
 
-		IStackItem* ret;
-		if (i1->CompareTo(i2) >= 0)
-		{
-			delete(i1);
-			ret = this->CreateInteger(i2);
-		}
-		else
-		{
-			delete(i2);
-			ret = this->CreateInteger(i1);
-		}
+		// Only the result is decoded
+
+		BigInteger temp, reti;
+		reti = *StackItemConverter::GetBigInteger(cmp >= 0 ? x2 : x1, temp);
+		StackItemHelper::Free(x1, x2);
+
+		auto ret = this->CreateInteger(reti);
 
 		if (ret != nullptr)
 		{
@@ -2592,31 +2838,27 @@ void ExecutionEngine::InternalStepInto()
 		auto x2 = context->EvaluationStack.Pop();
 		auto x1 = context->EvaluationStack.Pop();
 
-		auto i2 = x2->GetBigInteger();
-		auto i1 = x1->GetBigInteger();
+		if (this->TryInt64<CheckedMath::Max>(context, x1, x2))
+		{
+			return;
+		}
 
-		StackItemHelper::Free(x1, x2);
+		int32 cmp;
 
-		if (i2 == nullptr || i1 == nullptr)
+		if (!StackItemConverter::CompareTo(x1, x2, cmp))
 		{
-			if (i2 != nullptr) delete(i2);
-			if (i1 != nullptr) delete(i1);
-
+			StackItemHelper::Free(x1, x2);
 			this->SetFault();
 			return;
 		}
 
-		IStackItem* ret;
-		if (i1->CompareTo(i2) >= 0)
-		{
-			delete(i2);
-			ret = this->CreateInteger(i1);
-		}
-		else
-		{
-			delete(i1);
-			ret = this->CreateInteger(i2);
-		}
+		// Only the result is decoded
+
+		BigInteger temp, reti;
+		reti = *StackItemConverter::GetBigInteger(cmp >= 0 ? x1 : x2, temp);
+		StackItemHelper::Free(x1, x2);
+
+		auto ret = this->CreateInteger(reti);
 
 		if (ret != nullptr)
 		{
@@ -2641,27 +2883,17 @@ void ExecutionEngine::InternalStepInto()
 		auto a = context->EvaluationStack.Pop();
 		auto x = context->EvaluationStack.Pop();
 
-		auto ib = b->GetBigInteger();
-		auto ia = a->GetBigInteger();
-		auto ix = x->GetBigInteger();
-
+		int32 cmpa, cmpb;
+		bool ok = StackItemConverter::CompareTo(a, x, cmpa) && StackItemConverter::CompareTo(x, b, cmpb);
 		StackItemHelper::Free(b, a, x);
 
-		if (ib == nullptr || ia == nullptr || ix == nullptr)
+		if (!ok)
 		{
-			if (ib != nullptr) delete(ib);
-			if (ia != nullptr) delete(ia);
-			if (ix != nullptr) delete(ix);
-
 			this->SetFault();
 			return;
 		}
 
-		auto ret = this->CreateBool(ia->CompareTo(ix) <= 0 && ix->CompareTo(ib) < 0);
-
-		delete(ib);
-		delete(ia);
-		delete(ix);
+		auto ret = this->CreateBool(cmpa <= 0 && cmpb < 0);
 
 		if (ret != nullptr)
 		{
@@ -2686,29 +2918,20 @@ void ExecutionEngine::InternalStepInto()
 		}
 
 		auto item = context->EvaluationStack.Pop();
-		int32 size = item->ReadByteArraySize();
 
-		if (size < 0)
-		{
-			StackItemHelper::Free(item);
-			this->SetFault();
-			return;
-		}
-
-		byte* data = new byte[size];
-		size = item->ReadByteArray(data, 0, size);
-		StackItemHelper::Free(item);
+		const byte* data;
+		int32 size = StackItemConverter::GetByteArrayView(item, data);
 
 		if (size < 0)
 		{
-			delete[]data;
+			StackItemHelper::Free(item);
 			this->SetFault();
 			return;
 		}
 
 		byte* hash = new byte[Crypto::SHA1_LENGTH];
 		Crypto::ComputeSHA1(data, size, hash);
-		delete[]data;
+		StackItemHelper::Free(item);
 
 		auto ret = this->CreateByteArray(hash, Crypto::SHA1_LENGTH, true);
 
@@ -2732,29 +2955,20 @@ void ExecutionEngine::InternalStepInto()
 		}
 
 		auto it = context->EvaluationStack.Pop();
-		int32 size = it->ReadByteArraySize();
 
-		if (size < 0)
-		{
-			StackItemHelper::Free(it);
-			this->SetFault();
-			return;
-		}
-
-		byte* data = new byte[size];
-		size = it->ReadByteArray(data, 0, size);
-		StackItemHelper::Free(it);
+		const byte* data;
+		int32 size = StackItemConverter::GetByteArrayView(it, data);
 
 		if (size < 0)
 		{
-			delete[]data;
+			StackItemHelper::Free(it);
 			this->SetFault();
 			return;
 		}
 
 		byte* hash = new byte[Crypto::SHA256_LENGTH];
 		Crypto::ComputeSHA256(data, size, hash);
-		delete[]data;
+		StackItemHelper::Free(it);
 
 		auto ret = this->CreateByteArray(hash, Crypto::SHA256_LENGTH, true);
 
@@ -2778,29 +2992,20 @@ void ExecutionEngine::InternalStepInto()
 		}
 
 		auto item = context->EvaluationStack.Pop();
-		int32 size = item->ReadByteArraySize();
 
-		if (size < 0)
-		{
-			StackItemHelper::Free(item);
-			this->SetFault();
-			return;
-		}
-
-		byte* data = new byte[size];
-		size = item->ReadByteArray(data, 0, size);
-		StackItemHelper::Free(item);
+		const byte* data;
+		int32 size = StackItemConverter::GetByteArrayView(item, data);
 
 		if (size < 0)
 		{
-			delete[]data;
+			StackItemHelper::Free(item);
 			this->SetFault();
 			return;
 		}
 
 		byte* hash = new byte[Crypto::HASH160_LENGTH];
 		Crypto::ComputeHash160(data, size, hash);
-		delete[]data;
+		StackItemHelper::Free(item);
 
 		auto ret = this->CreateByteArray(hash, Crypto::HASH160_LENGTH, true);
 
@@ -2824,29 +3029,20 @@ void ExecutionEngine::InternalStepInto()
 		}
 
 		auto it = context->EvaluationStack.Pop();
-		int32 size = it->ReadByteArraySize();
-
-		if (size < 0)
-		{
-			StackItemHelper::Free(it);
-			this->SetFault();
-			return;
-		}
 
-		byte* data = new byte[size];
-		size = it->ReadByteArray(data, 0, size);
-		StackItemHelper::Free(it);
+		const byte* data;
+		int32 size = StackItemConverter::GetByteArrayView(it, data);
 
 		if (size < 0)
 		{
-			delete[]data;
+			StackItemHelper::Free(it);
 			this->SetFault();
 			return;
 		}
 
 		byte* hash = new byte[Crypto::HASH256_LENGTH];
 		Crypto::ComputeHash256(data, size, hash);
-		delete[]data;
+		StackItemHelper::Free(it);
 
 		auto ret = this->CreateByteArray(hash, Crypto::HASH256_LENGTH, true);
 
@@ -2872,30 +3068,17 @@ void ExecutionEngine::InternalStepInto()
 		auto ipubKey = context->EvaluationStack.Pop();
 		auto isignature = context->EvaluationStack.Pop();
 
-		int32 pubKeySize = ipubKey->ReadByteArraySize();
-		int32 signatureSize = isignature->ReadByteArraySize();
-
-		if (this->OnGetMessage == nullptr || pubKeySize < 33 || signatureSize < 32)
-		{
-			StackItemHelper::Free(ipubKey, isignature);
-
-			auto ret = this->CreateBool(false);
-			if (ret != nullptr)
-			{
-				context->EvaluationStack.Push(ret);
-			}
-			return;
-		}
-
-		// Read message
+		const byte* pubKey;
+		const byte* signature;
+		int32 pubKeySize = StackItemConverter::GetByteArrayView(ipubKey, pubKey);
+		int32 signatureSize = StackItemConverter::GetByteArrayView(isignature, signature);
 
-		// TODO: dangerous way to get the message
+		const byte* hash = nullptr;
 
-		byte* msg;
-		int32 msgL = this->OnGetMessage(this->_iteration, msg);
-		if (msgL <= 0)
+		if (pubKeySize < 33 || signatureSize < 32 || (hash = this->GetMessageHash()) == nullptr)
 		{
 			StackItemHelper::Free(ipubKey, isignature);
+
 			auto ret = this->CreateBool(false);
 			if (ret != nullptr)
 			{
@@ -2904,20 +3087,7 @@ void ExecutionEngine::InternalStepInto()
 			return;
 		}
 
-		// Read public Key
-
-		byte* pubKey = new byte[pubKeySize];
-		pubKeySize = ipubKey->ReadByteArray(pubKey, 0, pubKeySize);
-
-		// Read signature
-
-		byte* signature = new byte[signatureSize];
-		signatureSize = isignature->ReadByteArray(signature, 0, signatureSize);
-
-		int16 ret = Crypto::VerifySignature(msg, msgL, signature, signatureSize, pubKey, pubKeySize);
-
-		delete[](pubKey);
-		delete[](signature);
+		int16 ret = Crypto::VerifyDigest(hash, signature, signatureSize, pubKey, pubKeySize);
 
 		StackItemHelper::Free(ipubKey, isignature);
 
@@ -2945,9 +3115,12 @@ void ExecutionEngine::InternalStepInto()
 		auto isignature = context->EvaluationStack.Pop();
 		auto imsg = context->EvaluationStack.Pop();
 
-		int32 pubKeySize = ipubKey->ReadByteArraySize();
-		int32 signatureSize = isignature->ReadByteArraySize();
-		int32 msgSize = imsg->ReadByteArraySize();
+		const byte* pubKey;
+		const byte* signature;
+		const byte* msg;
+		int32 pubKeySize = StackItemConverter::GetByteArrayView(ipubKey, pubKey);
+		int32 signatureSize = StackItemConverter::GetByteArrayView(isignature, signature);
+		int32 msgSize = StackItemConverter::GetByteArrayView(imsg, msg);
 
 		if (pubKeySize < 33 || signatureSize < 32 || msgSize < 0)
 		{
@@ -2960,27 +3133,8 @@ void ExecutionEngine::InternalStepInto()
 			return;
 		}
 
-		// Read message
-
-		byte* msg = new byte[msgSize];
-		msgSize = imsg->ReadByteArray(msg, 0, msgSize);
-
-		// Read public Key
-
-		byte* pubKey = new byte[pubKeySize];
-		pubKeySize = ipubKey->ReadByteArray(pubKey, 0, pubKeySize);
-
-		// Read signature
-
-		byte* signature = new byte[signatureSize];
-		signatureSize = isignature->ReadByteArray(signature, 0, signatureSize);
-
 		int16 ret = Crypto::VerifySignature(msg, msgSize, signature, signatureSize, pubKey, pubKeySize);
 
-		delete[](msg);
-		delete[](pubKey);
-		delete[](signature);
-
 		StackItemHelper::Free(imsg, ipubKey, isignature);
 
 		auto retres = this->CreateBool(ret == 0x01);
@@ -3000,8 +3154,12 @@ void ExecutionEngine::InternalStepInto()
 			return;
 		}
 
-		byte** pubKeys = nullptr;
-		byte** signatures = nullptr;
+		// The keys and the signatures are read from the items memory, so the items are kept until the end
+
+		Stack<IStackItem> items;
+
+		const byte** pubKeys = nullptr;
+		const byte** signatures = nullptr;
 		int32* pubKeysL = nullptr;
 		int32* signaturesL = nullptr;
 		int32 pubKeysCount = 0, signaturesCount = 0;
@@ -3011,6 +3169,9 @@ void ExecutionEngine::InternalStepInto()
 			auto item = context->EvaluationStack.Pop();
 			ic--;
 
+			item->Claim();
+			items.Push(item);
+
 			if (item->Type == EStackItemType::Array || item->Type == EStackItemType::Struct)
 			{
 				auto arr = (ArrayStackItem*)item;
@@ -3022,24 +3183,19 @@ void ExecutionEngine::InternalStepInto()
 				}
 				else
 				{
-					byte** data = new byte*[v];
+					const byte** data = new const byte*[v];
 					int32* dataL = new int32[v];
 
 					for (int32 i = 0; i < v; ++i)
 					{
 						auto ret = arr->Get(i);
 
-						int32 c = ret->ReadByteArraySize();
-						if (c < 0)
+						dataL[i] = StackItemConverter::GetByteArrayView(ret, data[i]);
+						if (dataL[i] < 0)
 						{
 							data[i] = nullptr;
-							dataL[i] = c;
 							this->SetFault();
-							continue;
 						}
-
-						data[i] = new byte[c];
-						dataL[i] = ret->ReadByteArray(data[i], 0, c);
 					}
 
 					// Equal
@@ -3061,13 +3217,13 @@ void ExecutionEngine::InternalStepInto()
 			else
 			{
 				int32 v = 0;
-				if (!item->GetInt32(v) || v < 1 || v > ic)
+				if (!StackItemConverter::GetInt32(item, v) || v < 1 || v > ic)
 				{
 					this->SetFault();
 				}
 				else
 				{
-					byte** data = new byte*[v];
+					const byte** data = new const byte*[v];
 					int32* dataL = new int32[v];
 
 					for (int32 i = 0; i < v; ++i)
@@ -3075,19 +3231,15 @@ void ExecutionEngine::InternalStepInto()
 						auto ret = context->EvaluationStack.Pop();
 						ic--;
 
-						int32 c = ret->ReadByteArraySize();
-						if (c < 0)
+						ret->Claim();
+						items.Push(ret);
+
+						dataL[i] = StackItemConverter::GetByteArrayView(ret, data[i]);
+						if (dataL[i] < 0)
 						{
 							data[i] = nullptr;
-							dataL[i] = c;
 							this->SetFault();
-							continue;
 						}
-
-						data[i] = new byte[c];
-						dataL[i] = ret->ReadByteArray(data[i], 0, c);
-
-						StackItemHelper::Free(ret);
 					}
 
 					// Equal
@@ -3106,8 +3258,6 @@ void ExecutionEngine::InternalStepInto()
 					}
 				}
 			}
-
-			StackItemHelper::Free(item);
 		}
 
 		// Check fault
@@ -3119,78 +3269,40 @@ void ExecutionEngine::InternalStepInto()
 
 		this->AddGasCost(100 * signaturesCount);
 
-		if (this->_state != EVMState::NONE || this->OnGetMessage == nullptr)
-		{
-			// Free
-
-			if (pubKeys != nullptr)	delete[](pubKeys);
-			if (signatures != nullptr) delete[](signatures);
-			if (pubKeysL != nullptr)	delete[](pubKeysL);
-			if (signaturesL != nullptr)delete[](signaturesL);
-
-			// Return
-
-			if (this->_state == EVMState::NONE)
-			{
-				auto ret = this->CreateBool(false);
-
-				if (ret != nullptr)
-				{
-					context->EvaluationStack.Push(ret);
-				}
-			}
+		bool fSuccess = false;
 
-			return;
-		}
-
-		// Read message
-
-		// TODO: dangerous way to get the message
-
-		byte* msg;
-		int32 msgL = this->OnGetMessage(this->_iteration, msg);
-
-		if (msgL <= 0)
+		if (this->_state == EVMState::NONE)
 		{
-			if (pubKeys != nullptr)	delete[](pubKeys);
-			if (signatures != nullptr) delete[](signatures);
-			if (pubKeysL != nullptr)	delete[](pubKeysL);
-			if (signaturesL != nullptr)delete[](signaturesL);
-
-			auto ret = this->CreateBool(false);
+			const byte* hash = this->GetMessageHash();
 
-			if (ret != nullptr)
+			if (hash != nullptr)
 			{
-				context->EvaluationStack.Push(ret);
+				fSuccess = SignatureVerifier::VerifyMultisig(hash, signatures, signaturesL, signaturesCount,
+					pubKeys, pubKeysL, pubKeysCount, this->_verificationThreads);
 			}
-			return;
 		}
 
-		bool fSuccess = true;
-		for (int32 i = 0, j = 0; fSuccess && i < signaturesCount && j < pubKeysCount;)
-		{
-			if (Crypto::VerifySignature(msg, msgL, signatures[i], signaturesL[i], pubKeys[j], pubKeysL[j]))
-				++i;
-
-			j++;
-
-			if (signaturesCount - i > pubKeysCount - j)
-			{
-				fSuccess = false;
-				break;
-			}
-		}
+		// Free
 
 		if (pubKeys != nullptr)	delete[](pubKeys);
 		if (signatures != nullptr) delete[](signatures);
 		if (pubKeysL != nullptr)	delete[](pubKeysL);
 		if (signaturesL != nullptr)delete[](signaturesL);
 
-		auto ret = this->CreateBool(fSuccess);
+		while (items.Count() > 0)
+		{
+			auto item = items.Pop();
+			StackItemHelper::UnclaimAndFree(item);
+		}
 
-		if (ret != nullptr)
+		if (this->_state == EVMState::NONE)
 		{
-			context->EvaluationStack.Push(ret);
+			auto ret = this->CreateBool(fSuccess);
+
+			if (ret != nullptr)
+			{
+				context->EvaluationStack.Push(ret);
+			}
 		}
 		return;
 	}
@@ -3230,7 +3342,7 @@ void ExecutionEngine::InternalStepInto()
 		}
 		default:
 		{
-			size = item->ReadByteArraySize();
+			size = StackItemConverter::ReadByteArraySize(item);
 			break;
 		}
 		}
@@ -3269,7 +3381,7 @@ void ExecutionEngine::InternalStepInto()
 		int32 size = 0;
 		auto item = context->EvaluationStack.Pop();
 
-		if (!item->GetInt32(size) || size < 0 || size >(ec - 1) || size > MAX_ARRAY_SIZE)
+		if (!StackItemConverter::GetInt32(item, size) || size < 0 || size >(ec - 1) || size > MAX_ARRAY_SIZE)
 		{
 			StackItemHelper::Free(item);
 			this->SetFault();
@@ -3283,7 +3395,11 @@ void ExecutionEngine::InternalStepInto()
 
 		for (int32 i = 0; i < size; ++i)
 		{
-			items->Add(context->EvaluationStack.Pop());
+			// Free it if it was packed
+
+			auto it = context->EvaluationStack.Pop();
+			items->Add(it);
+			StackItemHelper::Free(it);
 		}
 
 		context->EvaluationStack.Push(items);
@@ -3311,7 +3427,7 @@ void ExecutionEngine::InternalStepInto()
 
 			for (int32 i = count - 1; i >= 0; i--)
 			{
-				context->EvaluationStack.Push(array->Get(i));
+				context->EvaluationStack.Push(array->GetMutable(i));
 			}
 
 			StackItemHelper::Free(it);
@@ -3365,7 +3481,7 @@ void ExecutionEngine::InternalStepInto()
 			auto arr = (ArrayStackItem*)item;
 
 			int32 index = 0;
-			if (!key->GetInt32(index) || index < 0 || index >= arr->Count())
+			if (!StackItemConverter::GetInt32(key, index) || index < 0 || index >= arr->Count())
 			{
 				break;
 			}
@@ -3443,7 +3559,7 @@ void ExecutionEngine::InternalStepInto()
 			auto arr = (ArrayStackItem*)item;
 
 			int32 index = 0;
-			if (!key->GetInt32(index) || index < 0 || index >= arr->Count())
+			if (!StackItemConverter::GetInt32(key, index) || index < 0 || index >= arr->Count())
 			{
 				StackItemHelper::Free(key, item, value);
 
@@ -3453,7 +3569,10 @@ void ExecutionEngine::InternalStepInto()
 
 			arr->Set(index, value);
 
-			StackItemHelper::Free(key, item);
+			// The value is freed if it was packed, before the array that could own it
+
+			StackItemHelper::Free(key, value);
+			StackItemHelper::Free(item);
 			return;
 		}
 		case EStackItemType::Map:
@@ -3495,7 +3614,7 @@ void ExecutionEngine::InternalStepInto()
 		int32 count = 0;
 		auto item = context->EvaluationStack.Pop();
 
-		if (!item->GetInt32(count) || count < 0 || count > MAX_ARRAY_SIZE)
+		if (!StackItemConverter::GetInt32(item, count) || count < 0 || count > MAX_ARRAY_SIZE)
 		{
 			StackItemHelper::Free(item);
 			this->SetFault();
@@ -3527,7 +3646,7 @@ void ExecutionEngine::InternalStepInto()
 		int32 count = 0;
 		auto item = context->EvaluationStack.Pop();
 
-		if (!item->GetInt32(count) || count < 0 || count > MAX_ARRAY_SIZE)
+		if (!StackItemConverter::GetInt32(item, count) || count < 0 || count > MAX_ARRAY_SIZE)
 		{
 			StackItemHelper::Free(item);
 			this->SetFault();
@@ -3596,7 +3715,9 @@ void ExecutionEngine::InternalStepInto()
 				arr->Add(newItem);
 			}
 
-			StackItemHelper::Free(item);
+			// The new item is freed if it was packed
+
+			StackItemHelper::Free(newItem, item);
 			return;
 		}
 		default:
@@ -3667,7 +3788,7 @@ void ExecutionEngine::InternalStepInto()
 			auto arr = (ArrayStackItem*)item;
 
 			int32 index = 0;
-			if (!key->GetInt32(index) || index < 0 || index >= arr->Count())
+			if (!StackItemConverter::GetInt32(key, index) || index < 0 || index >= arr->Count())
 			{
 				StackItemHelper::Free(key, item);
 
@@ -3731,7 +3852,7 @@ void ExecutionEngine::InternalStepInto()
 			auto arr = (ArrayStackItem*)item;
 
 			int32 index = 0;
-			if (!key->GetInt32(index) || index < 0)
+			if (!StackItemConverter::GetInt32(key, index) || index < 0)
 			{
 				StackItemHelper::Free(key, item);
 
@@ -3884,7 +4005,7 @@ void ExecutionEngine::InternalStepInto()
 
 		auto it = context->EvaluationStack.Pop();
 
-		if (!it->GetBoolean())
+		if (!StackItemConverter::GetBoolean(it))
 		{
 			this->SetFault();
 		}
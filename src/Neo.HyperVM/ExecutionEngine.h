@@ -4,7 +4,9 @@
 #include <memory>
 #include "Types.h"
 #include "Limits.h"
+#include "Crypto.h"
 #include "StackItems.h"
+#include "ValueStack.h"
 #include "ExecutionContextStack.h"
 #include "EVMState.h"
 #include "IStackItemCounter.h"
@@ -26,6 +28,18 @@ private:
 	uint64 _maxGas;
 	IStackItemCounter *_counter;
 
+	// Threads that verify the signatures of CHECKMULTISIG, 1 verifies them on the engine thread
+
+	int32 _verificationThreads;
+
+	// Message of the signature checks, read once per iteration (until the next Clean) and kept as its SHA256
+
+	bool _messageLoaded;
+	int32 _messageLength;
+	byte _messageHash[Crypto::SHA256_LENGTH];
+
+	const byte* GetMessageHash();
+
 	// Save the state of the execution
 
 	EVMState _state;
@@ -41,8 +55,26 @@ private:
 
 	std::list<std::shared_ptr<ExecutionScript>> Scripts;
 
+	// Scripts loaded before the last reset, reused when the same content is loaded again
+
+	std::list<std::shared_ptr<ExecutionScript>> _scriptCache;
+
+	std::shared_ptr<ExecutionScript> GetCachedScript(byte* script, int32 scriptLength);
+
+	// Evaluation stacks of all the contexts share the same value stack
+
+	ValueStack _valueStack;
+
 	void InternalStepInto();
 
+	// Int64 fast path of the integer opcodes, false (and the operands kept) when they or the result don't fit
+
+	template<bool(*Operation)(int64, int64&)>
+	bool TryInt64(ExecutionContext* context, IStackItem* &it);
+
+	template<bool(*Operation)(int64, int64, int64&)>
+	bool TryInt64(ExecutionContext* context, IStackItem* &i1, IStackItem* &i2);
+
 	inline void SetHalt()
 	{
 		this->_state = EVMState::HALT;
@@ -115,6 +147,16 @@ public:
 		return this->_consumedGas;
 	}
 
+	inline uint64 GetMemoryUsage() const
+	{
+		return (uint64)this->_counter->GetMemory();
+	}
+
+	inline uint64 GetPeakMemoryUsage() const
+	{
+		return (uint64)this->_counter->GetPeakMemory();
+	}
+
 	// Setters
 
 	inline void SetLogCallback(OnStepIntoCallback &logCallback)
@@ -122,7 +164,37 @@ public:
 		this->Log = logCallback;
 	}
 
+	inline void SetCallbacks(InvokeInteropCallback &invokeInterop, LoadScriptCallback &loadScript, GetMessageCallback &getMessage)
+	{
+		this->OnGetMessage = getMessage;
+		this->OnLoadScript = loadScript;
+		this->OnInvokeInterop = invokeInterop;
+	}
+
+	inline void SetMemoryLimit(uint64 limit)
+	{
+		this->_counter->SetMaxMemory(limit > 0x7FFFFFFFFFFFFFFFULL ? 0x7FFFFFFFFFFFFFFFLL : (int64)limit);
+	}
+
+	inline void SetVerificationThreads(int32 threads)
+	{
+		this->_verificationThreads = threads < 1 ? 1 : (threads > MAX_VERIFICATION_THREADS ? MAX_VERIFICATION_THREADS : threads);
+	}
+
+	// Message of the current iteration, so the signature checks don't ask the host. The hash is optional
+
+	void SetMessage(const byte* message, int32 messageLength, const byte* hash);
+
+	// False when there was no free counter id for the engine, then it must be freed
+
+	inline bool IsValid() const
+	{
+		return this->_counter->IsRegistered();
+	}
+
 	void Clean(uint32 iteration);
+	bool Reset(InvokeInteropCallback &invokeInterop, LoadScriptCallback &loadScript, GetMessageCallback &getMessage);
+	ExecutionEngine* Fork(InvokeInteropCallback &invokeInterop, LoadScriptCallback &loadScript, GetMessageCallback &getMessage);
 
 	// Run
 
@@ -156,7 +228,18 @@ public:
 		return new IntegerStackItem(_counter, value);
 	}
 
-	inline IntegerStackItem* CreateInteger(BigInteger *value)
+	inline IntegerStackItem* CreateInteger(int64 value)
+	{
+		if (!this->_counter->ItemCounterInc())
+		{
+			this->_state = EVMState::FAULT;
+			return nullptr;
+		}
+
+		return new IntegerStackItem(_counter, value);
+	}
+
+	inline IntegerStackItem* CreateInteger(const BigInteger &value)
 	{
 		if (!this->_counter->ItemCounterInc())
 		{
@@ -241,14 +324,7 @@ public:
 			return nullptr;
 		}
 
-		auto ret = new ArrayStackItem(_counter, false);
-
-		for (int32 i = 0; i < count; ++i)
-		{
-			ret->Add(new BoolStackItem(_counter, false));
-		}
-
-		return ret;
+		return new ArrayStackItem(_counter, false, count);
 	}
 
 	inline ArrayStackItem* CreateStruct(int32 count)
@@ -259,14 +335,7 @@ public:
 			return nullptr;
 		}
 
-		auto ret = new ArrayStackItem(_counter, true);
-
-		for (int32 i = 0; i < count; ++i)
-		{
-			ret->Add(new BoolStackItem(_counter, false));
-		}
-
-		return ret;
+		return new ArrayStackItem(_counter, true, count);
 	}
 
 	// Constructor
@@ -44,6 +44,6 @@ public:
 
 	inline ~ExecutionScript()
 	{
-		delete(this->Content);
+		delete[](this->Content);
 	}
 };
\ No newline at end of file
@@ -45,10 +45,23 @@ void ExecutionContext_Claim(ExecutionContext* context, StackItems* &evStack, Sta
 {
 	if (context == nullptr) return;
 
+	// Claimed contexts are not reused until the host releases them
+
+	context->Claim();
+
 	evStack = &context->EvaluationStack;
 	altStack = &context->AltStack;
 }
 
+void ExecutionContext_UnClaim(ExecutionContext* context)
+{
+	if (context == nullptr || context->IsUnClaimed()) return;
+
+	// Reused after the next clean, when it was already released by the engine
+
+	context->UnClaim();
+}
+
 // ExecutionEngine
 
 ExecutionEngine* ExecutionEngine_Create
@@ -59,12 +72,49 @@ ExecutionEngine* ExecutionEngine_Create
 {
 	auto engine = new ExecutionEngine(interopCallback, getScriptCallback, getMessageCallback);
 
+	// All the counter ids are in use
+
+	if (!engine->IsValid())
+	{
+		delete(engine);
+
+		invStack = nullptr;
+		resStack = nullptr;
+		return nullptr;
+	}
+
 	invStack = &engine->InvocationStack;
 	resStack = &engine->ResultStack;
 
 	return engine;
 }
 
+ExecutionEngine* ExecutionEngine_Fork
+(
+	ExecutionEngine* engine,
+	InvokeInteropCallback interopCallback, LoadScriptCallback getScriptCallback, GetMessageCallback getMessageCallback,
+	ExecutionContextStack* &invStack, StackItems* &resStack
+)
+{
+	if (engine == nullptr) return nullptr;
+
+	// Same state and stacks, but the fork runs independently with its own callbacks
+
+	auto fork = engine->Fork(interopCallback, getScriptCallback, getMessageCallback);
+
+	if (fork == nullptr)
+	{
+		invStack = nullptr;
+		resStack = nullptr;
+		return nullptr;
+	}
+
+	invStack = &fork->InvocationStack;
+	resStack = &fork->ResultStack;
+
+	return fork;
+}
+
 void ExecutionEngine_Clean(ExecutionEngine* engine, uint32 iteration)
 {
 	if (engine == nullptr) return;
@@ -72,6 +122,31 @@ void ExecutionEngine_Clean(ExecutionEngine* engine, uint32 iteration)
 	engine->Clean(iteration);
 }
 
+byte ExecutionEngine_Reset
+(
+	ExecutionEngine* engine,
+	InvokeInteropCallback interopCallback, LoadScriptCallback getScriptCallback, GetMessageCallback getMessageCallback
+)
+{
+	if (engine == nullptr) return 0x00;
+
+	// Back to the state of a new engine, keeping the allocated stacks, contexts and the recent scripts.
+	// On failure the engine must be freed
+
+	return engine->Reset(interopCallback, getScriptCallback, getMessageCallback) ? 0x01 : 0x00;
+}
+
+void ExecutionEngine_SetCallbacks
+(
+	ExecutionEngine* engine,
+	InvokeInteropCallback interopCallback, LoadScriptCallback getScriptCallback, GetMessageCallback getMessageCallback
+)
+{
+	if (engine == nullptr) return;
+
+	engine->SetCallbacks(interopCallback, getScriptCallback, getMessageCallback);
+}
+
 void ExecutionEngine_AddLog(ExecutionEngine* engine, OnStepIntoCallback callback)
 {
 	if (engine == nullptr) return;
@@ -150,6 +225,41 @@ uint64 ExecutionEngine_GetConsumedGas(ExecutionEngine* engine)
 	return engine->GetConsumedGas();
 }
 
+uint64 ExecutionEngine_GetMemoryUsage(ExecutionEngine* engine)
+{
+	if (engine == nullptr) return 0;
+
+	return engine->GetMemoryUsage();
+}
+
+uint64 ExecutionEngine_GetPeakMemoryUsage(ExecutionEngine* engine)
+{
+	if (engine == nullptr) return 0;
+
+	return engine->GetPeakMemoryUsage();
+}
+
+void ExecutionEngine_SetMemoryLimit(ExecutionEngine* engine, uint64 limit)
+{
+	if (engine == nullptr) return;
+
+	engine->SetMemoryLimit(limit);
+}
+
+void ExecutionEngine_SetVerificationThreads(ExecutionEngine* engine, int32 threads)
+{
+	if (engine == nullptr) return;
+
+	engine->SetVerificationThreads(threads);
+}
+
+void ExecutionEngine_SetMessage(ExecutionEngine* engine, byte* message, int32 messageLength, byte* hash)
+{
+	if (engine == nullptr || (message == nullptr && hash == nullptr && messageLength > 0)) return;
+
+	engine->SetMessage(message, messageLength, hash);
+}
+
 // StackItems
 
 int32 StackItems_Drop(StackItems* stack, int32 count)
@@ -367,7 +477,7 @@ IStackItem* ArrayStackItem_Get(ArrayStackItem* array, int32 index)
 {
 	if (array == nullptr) return nullptr;
 
-	return array->Get(index);
+	return array->GetMutable(index);
 }
 
 void ArrayStackItem_Add(ArrayStackItem* array, IStackItem* item)
@@ -26,6 +26,7 @@ extern "C"
 	DllExport EVMOpCode __stdcall ExecutionContext_GetNextInstruction(ExecutionContext* context);
 	DllExport int32 __stdcall ExecutionContext_GetInstructionPointer(ExecutionContext* context);
 	DllExport void __stdcall ExecutionContext_Claim(ExecutionContext* context, StackItems* &evStack, StackItems* &altStack);
+	DllExport void __stdcall ExecutionContext_UnClaim(ExecutionContext* context);
 
 	// ExecutionEngine
 
@@ -34,8 +35,24 @@ extern "C"
 		InvokeInteropCallback interopCallback, LoadScriptCallback getScriptCallback, GetMessageCallback getMessageCallback,
 		ExecutionContextStack* &invStack, StackItems* &resStack
 	);
+	DllExport ExecutionEngine* __stdcall ExecutionEngine_Fork
+	(
+		ExecutionEngine* engine,
+		InvokeInteropCallback interopCallback, LoadScriptCallback getScriptCallback, GetMessageCallback getMessageCallback,
+		ExecutionContextStack* &invStack, StackItems* &resStack
+	);
 	DllExport void __stdcall ExecutionEngine_Free(ExecutionEngine* &engine);
 	DllExport void __stdcall ExecutionEngine_Clean(ExecutionEngine* engine, uint32 iteration);
+	DllExport byte __stdcall ExecutionEngine_Reset
+	(
+		ExecutionEngine* engine,
+		InvokeInteropCallback interopCallback, LoadScriptCallback getScriptCallback, GetMessageCallback getMessageCallback
+	);
+	DllExport void __stdcall ExecutionEngine_SetCallbacks
+	(
+		ExecutionEngine* engine,
+		InvokeInteropCallback interopCallback, LoadScriptCallback getScriptCallback, GetMessageCallback getMessageCallback
+	);
 	DllExport int32 __stdcall ExecutionEngine_LoadScript(ExecutionEngine* engine, byte* script, int32 scriptLength, int32 rvcount);
 	DllExport byte __stdcall ExecutionEngine_LoadCachedScript(ExecutionEngine* engine, int32 scriptIndex, int32 rvcount);
 	DllExport byte __stdcall ExecutionEngine_Execute(ExecutionEngine* engine, uint32 gas);
@@ -45,6 +62,11 @@ extern "C"
 	DllExport void __stdcall ExecutionEngine_StepOut(ExecutionEngine* engine);
 	DllExport byte __stdcall ExecutionEngine_GetState(ExecutionEngine* engine);
 	DllExport uint64 __stdcall ExecutionEngine_GetConsumedGas(ExecutionEngine* engine);
+	DllExport uint64 __stdcall ExecutionEngine_GetMemoryUsage(ExecutionEngine* engine);
+	DllExport uint64 __stdcall ExecutionEngine_GetPeakMemoryUsage(ExecutionEngine* engine);
+	DllExport void __stdcall ExecutionEngine_SetMemoryLimit(ExecutionEngine* engine, uint64 limit);
+	DllExport void __stdcall ExecutionEngine_SetVerificationThreads(ExecutionEngine* engine, int32 threads);
+	DllExport void __stdcall ExecutionEngine_SetMessage(ExecutionEngine* engine, byte* message, int32 messageLength, byte* hash);
 	DllExport void __stdcall ExecutionEngine_AddLog(ExecutionEngine* engine, OnStepIntoCallback callback);
 
 	// StackItems
@@ -28,6 +28,11 @@ public:
 		this->_claims++;
 	}
 
+	inline int32 GetClaims() const
+	{
+		return this->_claims;
+	}
+
 	// Constructor
 
 	inline IClaimable() :_claims(0) { }
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "IStackItemCounter.h"
+#include "IStackItem.h"
+
+class ICompoundStackItem : public IStackItem
+{
+private:
+
+	friend class CycleCollector;
+	friend class StackItemCopier;
+
+	// Compound items of the same counter, walked by the cycle collector
+
+	ICompoundStackItem* _prevCompound;
+	ICompoundStackItem* _nextCompound;
+
+	// Claims not coming from other compound items, only valid while collecting
+
+	int32 _externalClaims;
+
+public:
+
+	// Constructor
+
+	inline ICompoundStackItem(IStackItemCounter* counter, EStackItemType type) :
+		IStackItem(counter, type),
+		_prevCompound(nullptr),
+		_nextCompound(counter->_compounds),
+		_externalClaims(0)
+	{
+		if (this->_nextCompound != nullptr)
+		{
+			this->_nextCompound->_prevCompound = this;
+		}
+
+		counter->_compounds = this;
+	}
+
+	// Destructor
+
+	virtual ~ICompoundStackItem()
+	{
+		if (this->_prevCompound != nullptr)
+		{
+			this->_prevCompound->_nextCompound = this->_nextCompound;
+		}
+		else
+		{
+			this->GetCounter()->_compounds = this->_nextCompound;
+		}
+
+		if (this->_nextCompound != nullptr)
+		{
+			this->_nextCompound->_prevCompound = this->_prevCompound;
+		}
+	}
+};
\ No newline at end of file
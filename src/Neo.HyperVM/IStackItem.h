@@ -7,9 +7,18 @@
 
 class IStackItem : public IClaimable
 {
+private:
+
+	// Only the id of the counter is stored, for keep the header in 16 bytes
+
+	const uint16 _counterId;
+
 protected:
 
-	IStackItemCounter* _counter;
+	inline IStackItemCounter* GetCounter() const
+	{
+		return IStackItemCounter::Get(this->_counterId);
+	}
 
 public:
 
@@ -18,40 +27,55 @@ public:
 	// Converters
 
 	virtual bool GetBoolean() = 0;
-	virtual BigInteger* GetBigInteger() = 0;
 	virtual bool GetInt32(int32 &ret) = 0;
+	virtual bool GetInt64(int64 &ret) = 0;
 	virtual bool Equals(IStackItem* it) = 0;
 	virtual int32 ReadByteArraySize() = 0;
 	virtual int32 ReadByteArray(byte* output, int32 sourceIndex, int32 count) = 0;
 
+	// Borrow the byte encoding without copy, the pointer is valid while the item is alive
+
+	virtual int32 GetByteArrayView(const byte* &data) = 0;
+
+	// Borrow the integer value, or decode it into temp when the item doesn't keep one.
+	// Null when it can't be converted, the pointer is valid while the item and temp are alive
+
+	virtual const BigInteger* GetBigInteger(BigInteger &temp) = 0;
+
 	// Serialize
 
 	virtual int32 Serialize(byte* data, int32 length) = 0;
 	virtual int32 GetSerializedSize() = 0;
 
+	// Content hash, must be the same for items that are Equals
+
+	virtual uint32 GetHash() = 0;
+
 	// Constructor
 
 	inline IStackItem(IStackItemCounter* counter, EStackItemType type) :
 		IClaimable(),
-		_counter(counter),
+		_counterId(counter->GetId()),
 		Type(type)
 	{
-		this->_counter->Claim();
+		counter->Claim();
 	}
 
 	// Destructor
 
 	virtual ~IStackItem()
 	{
-		if (this->_counter->UnClaim())
+		auto counter = this->GetCounter();
+
+		if (counter->UnClaim())
 		{
 			// Fail when dispose counter before this, for this reason the pointer is a reference pointer
 
-			delete(this->_counter);
+			delete(counter);
 		}
 		else
 		{
-			this->_counter->ItemCounterDec();
+			counter->ItemCounterDec();
 		}
 	};
 };
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "IStackItemCounter.h"
+#include <mutex>
+#include <vector>
+
+IStackItemCounter** IStackItemCounter::_registry[IStackItemCounter::RegistryPageSize] = { };
+
+static std::mutex _registryLock;
+static std::vector<uint16> _registryFree;
+static int32 _registryNext = 0;
+
+uint16 IStackItemCounter::Register(IStackItemCounter* counter)
+{
+	std::lock_guard<std::mutex> lock(_registryLock);
+
+	int32 id;
+
+	if (!_registryFree.empty())
+	{
+		id = _registryFree.back();
+		_registryFree.pop_back();
+	}
+	else
+	{
+		// The ids of the live counters are never given again
+
+		if (_registryNext >= InvalidId)
+		{
+			return InvalidId;
+		}
+
+		// Pages are never released, so Get() doesn't need the lock
+
+		id = _registryNext++;
+
+		if (_registry[id / RegistryPageSize] == nullptr)
+		{
+			_registry[id / RegistryPageSize] = new IStackItemCounter*[RegistryPageSize]();
+		}
+	}
+
+	_registry[id / RegistryPageSize][id % RegistryPageSize] = counter;
+	return (uint16)id;
+}
+
+void IStackItemCounter::Unregister(uint16 id)
+{
+	std::lock_guard<std::mutex> lock(_registryLock);
+
+	_registry[id / RegistryPageSize][id % RegistryPageSize] = nullptr;
+	_registryFree.push_back(id);
+}
@@ -3,18 +3,84 @@
 #include "Types.h"
 #include "IClaimable.h"
 
+class ICompoundStackItem;
+
 class IStackItemCounter : public IClaimable
 {
 private:
 
+	friend class ICompoundStackItem;
+	friend class CycleCollector;
+	friend class StackItemCopier;
+
 	int32 _items;
 	int32 _maxItems;
+	uint16 _id;
+
+	// Live compound items, and the item count that triggers the next cycle collection
+
+	ICompoundStackItem* _compounds;
+	int32 _collectAt;
+
+	// Bytes held by the live items (headers, payloads, limbs and container storage)
+
+	int64 _memory;
+	int64 _peakMemory;
+	int64 _maxMemory;
+
+	// Registered counters, items only store the id of their counter. The last id is never given
+
+	static const int32 RegistryPageSize = 256;
+	static IStackItemCounter** _registry[RegistryPageSize];
+
+	static uint16 Register(IStackItemCounter* counter);
+	static void Unregister(uint16 id);
 
 public:
 
+	static const uint16 InvalidId = 0xFFFF;
+
+	inline uint16 GetId() const
+	{
+		return this->_id;
+	}
+
+	// False when all the ids were in use, then the counter can't hold items
+
+	inline bool IsRegistered() const
+	{
+		return this->_id != InvalidId;
+	}
+
+	static inline IStackItemCounter* Get(uint16 id)
+	{
+		return _registry[id / RegistryPageSize][id % RegistryPageSize];
+	}
+
 	inline void ItemCounterClean()
 	{
 		this->_items = 0;
+		this->_collectAt = this->_maxItems / 2;
+		this->_peakMemory = this->_memory;
+	}
+
+	// Continue the count of other counter, for a copy of its engine
+
+	inline void ItemCounterCopy(const IStackItemCounter* counter)
+	{
+		this->_items = counter->_items;
+		this->_collectAt = counter->_collectAt;
+		this->_maxMemory = counter->_maxMemory;
+
+		if (this->_peakMemory < counter->_peakMemory)
+		{
+			this->_peakMemory = counter->_peakMemory;
+		}
+	}
+
+	inline bool IsCollectionPending() const
+	{
+		return this->_items >= this->_collectAt;
 	}
 
 	inline bool ItemCounterInc()
@@ -34,5 +100,60 @@ public:
 		--this->_items;
 	}
 
-	inline IStackItemCounter(int32 maxItems) : IClaimable(), _items(0), _maxItems(maxItems) {}
-};
\ No newline at end of file
+	// Memory
+
+	inline void MemoryInc(int64 bytes)
+	{
+		if ((this->_memory += bytes) > this->_peakMemory)
+		{
+			this->_peakMemory = this->_memory;
+		}
+	}
+
+	inline void MemoryDec(int64 bytes)
+	{
+		this->_memory -= bytes;
+	}
+
+	inline bool IsMemoryExceeded() const
+	{
+		return this->_memory > this->_maxMemory;
+	}
+
+	inline int64 GetMemory() const
+	{
+		return this->_memory;
+	}
+
+	inline int64 GetPeakMemory() const
+	{
+		return this->_peakMemory;
+	}
+
+	inline void SetMaxMemory(int64 maxMemory)
+	{
+		this->_maxMemory = maxMemory;
+	}
+
+	// Constructor & Destructor
+
+	inline IStackItemCounter(int32 maxItems) :
+		IClaimable(),
+		_items(0),
+		_maxItems(maxItems),
+		_id(Register(this)),
+		_compounds(nullptr),
+		_collectAt(maxItems / 2),
+		_memory(0),
+		_peakMemory(0),
+		_maxMemory(0x7FFFFFFFFFFFFFFFLL)
+	{ }
+
+	inline ~IStackItemCounter()
+	{
+		if (this->_id != InvalidId)
+		{
+			Unregister(this->_id);
+		}
+	}
+};
@@ -1,4 +1,20 @@
 #include "IntegerStackItem.h"
+#include "StackItemHelper.h"
+
+uint32 IntegerStackItem::GetHash()
+{
+	// Hash the byte encoding, so equal byte arrays and booleans collide. The value is immutable
+
+	if (this->_hash == 0)
+	{
+		const byte* data;
+		int32 size = this->GetByteArrayView(data);
+
+		this->_hash = StackItemHelper::Hash(data, size);
+	}
+
+	return this->_hash;
+}
 
 bool IntegerStackItem::Equals(IStackItem* it)
 {
@@ -13,38 +29,18 @@ bool IntegerStackItem::Equals(IStackItem* it)
 	}
 	default:
 	{
-		int32 i1 = it->ReadByteArraySize();
+		const byte* d1;
+		int32 i1 = it->GetByteArrayView(d1);
 
 		if (i1 < 0)
 		{
 			return false;
 		}
 
-		int32 i0 = this->ReadByteArraySize();
-		byte* d0 = new byte[i0];
-		byte* d1 = new byte[i1];
-
-		i0 = this->ReadByteArray(d0, 0, i0);
-		i1 = it->ReadByteArray(d1, 0, i1);
-
-		if (i1 != i0)
-		{
-			delete[](d0);
-			delete[](d1);
-			return false;
-		}
+		const byte* d0;
+		int32 i0 = this->GetByteArrayView(d0);
 
-		bool ret = true;
-		for (int32 x = 0; x < i0; ++x)
-			if (d0[x] != d1[x])
-			{
-				ret = false;
-				break;
-			}
-
-		delete[](d0);
-		delete[](d1);
-		return ret;
+		return i0 == i1 && memcmp(d0, d1, i0) == 0;
 	}
 	}
 }
\ No newline at end of file
@@ -1,13 +1,50 @@
 #pragma once
 #include "IStackItem.h"
 #include "BigInteger.h"
+#include <string.h>
 
-class IntegerStackItem : public IStackItem
+class IntegerStackItem final : public IStackItem
 {
 private:
 
 	BigInteger _value;
 
+	// Byte encoding, computed on the first byte access and counted as memory of the item
+
+	byte* _encoding;
+	int32 _encodingLength;
+
+	// Hash of the encoding, 0 until it's computed
+
+	uint32 _hash;
+
+	inline void EnsureEncoding()
+	{
+		if (this->_encoding != nullptr) return;
+
+		int32 size = this->_value.ToByteArraySize();
+
+		this->_encoding = new byte[size];
+		this->GetCounter()->MemoryInc(size);
+
+		this->_encodingLength = this->_value.ToByteArray(this->_encoding, size);
+	}
+
+	inline int32 CopyEncoding(byte* output, int32 count)
+	{
+		this->EnsureEncoding();
+
+		// Nothing is written when it doesn't fit, like BigInteger::ToByteArray
+
+		if (count < this->_encodingLength)
+		{
+			return 0;
+		}
+
+		memcpy(output, this->_encoding, this->_encodingLength);
+		return this->_encodingLength;
+	}
+
 public:
 
 	// Converters
@@ -17,9 +54,9 @@ public:
 		return this->_value.CompareTo(BigInteger::Zero) != 0;
 	}
 
-	inline BigInteger* GetBigInteger()
+	inline const BigInteger* GetBigInteger(BigInteger &temp)
 	{
-		return this->_value.Clone();
+		return &this->_value;
 	}
 
 	inline bool GetInt32(int32 &ret)
@@ -27,6 +64,11 @@ public:
 		return this->_value.ToInt32(ret);
 	}
 
+	inline bool GetInt64(int64 &ret)
+	{
+		return this->_value.ToInt64(ret);
+	}
+
 	inline int32 ReadByteArray(byte* output, int32 sourceIndex, int32 count)
 	{
 		if (sourceIndex != 0)
@@ -34,55 +76,95 @@ public:
 			return -1;
 		}
 
-		return this->_value.ToByteArray(output, count);
+		return this->CopyEncoding(output, count);
 	}
 
 	inline int32 ReadByteArraySize()
 	{
-		return this->_value.ToByteArraySize();
+		this->EnsureEncoding();
+		return this->_encodingLength;
+	}
+
+	inline int32 GetByteArrayView(const byte* &data)
+	{
+		this->EnsureEncoding();
+
+		data = this->_encoding;
+		return this->_encodingLength;
 	}
 
 	bool Equals(IStackItem* it);
 
+	// Hash
+
+	uint32 GetHash();
+
 	// Constructor
 
 	inline IntegerStackItem(IStackItemCounter* counter, byte* data, int32 size) :
 		IStackItem(counter, EStackItemType::Integer),
-		_value(data, size) { }
+		_value(data, size),
+		_encoding(nullptr),
+		_encodingLength(0),
+		_hash(0)
+	{
+		counter->MemoryInc(sizeof(IntegerStackItem) + this->_value.GetAllocatedSize());
+	}
 
 	inline IntegerStackItem(IStackItemCounter* counter, int32 value) :
 		IStackItem(counter, EStackItemType::Integer),
-		_value(value) { }
+		_value(value),
+		_encoding(nullptr),
+		_encodingLength(0),
+		_hash(0)
+	{
+		counter->MemoryInc(sizeof(IntegerStackItem) + this->_value.GetAllocatedSize());
+	}
 
-	inline IntegerStackItem(IStackItemCounter* counter, BigInteger* &value) :
+	inline IntegerStackItem(IStackItemCounter* counter, int64 value) :
 		IStackItem(counter, EStackItemType::Integer),
-		_value(value)
+		_value(value),
+		_encoding(nullptr),
+		_encodingLength(0),
+		_hash(0)
 	{
-		// TODO: I don't like this, should be used the same pointer
+		counter->MemoryInc(sizeof(IntegerStackItem) + this->_value.GetAllocatedSize());
+	}
 
-		delete(value);
-		value = nullptr;
+	inline IntegerStackItem(IStackItemCounter* counter, const BigInteger &value) :
+		IStackItem(counter, EStackItemType::Integer),
+		_value(value),
+		_encoding(nullptr),
+		_encodingLength(0),
+		_hash(0)
+	{
+		counter->MemoryInc(sizeof(IntegerStackItem) + this->_value.GetAllocatedSize());
 	}
 
 	// Destructor
 
 	inline ~IntegerStackItem()
 	{
-		/*if (this->Value == NULL) return;
+		this->GetCounter()->MemoryDec(sizeof(IntegerStackItem) + this->_value.GetAllocatedSize());
+
+		if (this->_encoding != nullptr)
+		{
+			this->GetCounter()->MemoryDec(this->_value.ToByteArraySize());
 
-		delete(this->Value);
-		this->Value = NULL;*/
+			delete[](this->_encoding);
+			this->_encoding = nullptr;
+		}
 	}
 
 	// Serialize
 
 	inline int32 Serialize(byte* data, int32 length)
 	{
-		return this->_value.ToByteArray(data, length);
+		return this->CopyEncoding(data, length);
 	}
 
 	inline int32 GetSerializedSize()
 	{
-		return this->_value.ToByteArraySize();
+		return this->ReadByteArraySize();
 	}
 };
\ No newline at end of file
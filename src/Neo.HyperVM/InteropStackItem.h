@@ -1,9 +1,10 @@
 #pragma once
 
 #include "IStackItem.h"
+#include "StackItemHelper.h"
 #include <string.h>
 
-class InteropStackItem : public IStackItem
+class InteropStackItem final : public IStackItem
 {
 private:
 
@@ -19,16 +20,27 @@ public:
 		return this->_payloadLength > 0;
 	}
 
-	inline BigInteger* GetBigInteger() { return nullptr; }
+	inline const BigInteger* GetBigInteger(BigInteger &temp) { return nullptr; }
 
 	inline bool GetInt32(int32 &ret) { return false; }
 
+	inline bool GetInt64(int64 &ret) { return false; }
+
 	inline int32 ReadByteArray(byte* output, int32 sourceIndex, int32 count) { return -1; }
 
 	inline int32 ReadByteArraySize() { return -1; }
 
+	inline int32 GetByteArrayView(const byte* &data) { return -1; }
+
 	bool Equals(IStackItem* it);
 
+	// Hash
+
+	inline uint32 GetHash()
+	{
+		return StackItemHelper::Hash(this->_payload, this->_payloadLength);
+	}
+
 	// Constructor
 
 	inline InteropStackItem(IStackItemCounter* counter, byte* data, int32 length)
@@ -37,12 +49,15 @@ public:
 		this->_payload = new byte[length];
 
 		memcpy(this->_payload, data, length);
+		counter->MemoryInc(sizeof(InteropStackItem) + length);
 	}
 
 	// Destructor
 
 	inline ~InteropStackItem()
 	{
+		this->GetCounter()->MemoryDec(sizeof(InteropStackItem) + this->_payloadLength);
+
 		if (this->_payload != nullptr)
 		{
 			delete[](this->_payload);
@@ -29,4 +29,16 @@ const int32 MAX_BIGINTEGER_SIZE = 32;
 /// <summary>
 /// Set the max Stack Size
 /// </summary>
-const int32 MAX_STACK_SIZE = 2 * 1024;
\ No newline at end of file
+const int32 MAX_STACK_SIZE = 2 * 1024;
+/// <summary>
+/// Max scripts kept by an engine between resets
+/// </summary>
+const int32 MAX_SCRIPT_CACHE_SIZE = 32;
+/// <summary>
+/// Max decoded public keys kept between signature checks
+/// </summary>
+const int32 MAX_PUBLIC_KEY_CACHE_SIZE = 1024;
+/// <summary>
+/// Max threads that verify the signatures of one CHECKMULTISIG
+/// </summary>
+const int32 MAX_VERIFICATION_THREADS = 8;
\ No newline at end of file
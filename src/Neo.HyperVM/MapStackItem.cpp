@@ -3,137 +3,157 @@
 
 bool MapStackItem::Remove(IStackItem* &key)
 {
-	for (auto it = this->_dictionary.begin(); it != this->_dictionary.end(); ++it)
-	{
-		if (!it->first->Equals(key)) continue;
-
-		auto value = it->second;
+	auto it = this->_index.find(MapKey{ key, key->GetHash() });
+	if (it == this->_index.end()) return false;
 
-		// Unclaim
+	auto &entry = this->_entries[it->second];
+	auto ckey = entry.Key; // Could be different
+	auto value = entry.Value;
 
-		auto ckey = it->first; // Could be different
+	// Unclaim
 
-		ckey->UnClaim();
-		value->UnClaim();
+	ckey->UnClaim();
+	value->UnClaim();
 
-		// Remove
+	// Leave the slot empty, the entries after it keep their index
 
-		this->_dictionary.erase(ckey);
+	this->_index.erase(it);
+	entry.Key = nullptr;
+	entry.Value = nullptr;
+	++this->_removed;
+	this->GetCounter()->MemoryDec(EntrySize);
 
-		// Free
+	while (!this->_entries.empty() && this->_entries.back().Key == nullptr)
+	{
+		this->_entries.pop_back();
+		--this->_removed;
+	}
 
-		bool equal = ckey == key;
-		StackItemHelper::Free(ckey, value);
-		if (equal) key = ckey;
+	// Compacted when most of the slots are empty, so each removal is O(1) amortized
 
-		return true;
+	if (this->_removed > this->Count())
+	{
+		this->Compact();
 	}
 
-	return false;
+	// Free
+
+	bool equal = ckey == key;
+	StackItemHelper::Free(ckey, value);
+	if (equal) key = ckey;
+
+	return true;
 }
 
-void MapStackItem::Clear()
+void MapStackItem::Compact()
 {
-	for (auto it = this->_dictionary.begin(); it != this->_dictionary.end(); ++it)
+	int32 count = 0;
+
+	for (int32 x = 0, m = static_cast<int32>(this->_entries.size()); x < m; ++x)
 	{
-		auto key = it->first;
-		auto value = it->second;
+		auto &entry = this->_entries[x];
 
-		StackItemHelper::UnclaimAndFree(key);
-		StackItemHelper::UnclaimAndFree(value);
-	}
+		if (entry.Key == nullptr) continue;
 
-	this->_dictionary.clear();
-}
+		if (x != count)
+		{
+			this->_entries[count] = entry;
+			this->_index.find(MapKey{ entry.Key, entry.Hash })->second = count;
+		}
 
-IStackItem* MapStackItem::Get(IStackItem* key)
-{
-	for (auto it = this->_dictionary.begin(); it != this->_dictionary.end(); ++it)
-	{
-		if (!it->first->Equals(key)) continue;
-		return it->second;
+		++count;
 	}
 
-	return nullptr;
+	this->_entries.resize(count);
+	this->_removed = 0;
 }
 
-IStackItem* MapStackItem::GetKey(int32 index)
+void MapStackItem::Clear()
 {
-	int32 ix = 0;
-	for (auto it = this->_dictionary.begin(); it != this->_dictionary.end(); ++it, ++ix)
+	this->GetCounter()->MemoryDec(this->Count() * EntrySize);
+
+	for (auto it = this->_entries.begin(); it != this->_entries.end(); ++it)
 	{
-		if (ix == index)
-		{
-			return it->first;
-		}
+		if (it->Key == nullptr) continue;
+
+		auto key = it->Key;
+		auto value = it->Value;
+
+		StackItemHelper::UnclaimAndFree(key);
+		StackItemHelper::UnclaimAndFree(value);
 	}
 
-	return nullptr;
+	this->_index.clear();
+	this->_entries.clear();
+	this->_removed = 0;
 }
 
-IStackItem* MapStackItem::GetValue(int32 index)
+IStackItem* MapStackItem::Get(IStackItem* key)
 {
-	int32 ix = 0;
-	for (auto it = this->_dictionary.begin(); it != this->_dictionary.end(); ++it, ++ix)
-	{
-		if (ix == index)
-		{
-			return it->second;
-		}
-	}
+	auto it = this->_index.find(MapKey{ key, key->GetHash() });
+	if (it == this->_index.end()) return nullptr;
 
-	return nullptr;
+	return this->_entries[it->second].Value;
 }
 
 void MapStackItem::FillKeys(ArrayStackItem* arr)
 {
-	for (auto it = this->_dictionary.begin(); it != this->_dictionary.end(); ++it)
+	for (auto it = this->_entries.begin(); it != this->_entries.end(); ++it)
 	{
-		if (it->first->Type == EStackItemType::Struct)
+		if (it->Key == nullptr) continue;
+
+		if (it->Key->Type == EStackItemType::Struct)
 		{
-			arr->Add(((ArrayStackItem*)it->first)->Clone());
+			arr->Add(((ArrayStackItem*)it->Key)->Clone());
 		}
 		else
 		{
-			arr->Add(it->first);
+			arr->Add(it->Key);
 		}
 	}
 }
 
 void MapStackItem::FillValues(ArrayStackItem* arr)
 {
-	for (auto it = this->_dictionary.begin(); it != this->_dictionary.end(); ++it)
+	for (auto it = this->_entries.begin(); it != this->_entries.end(); ++it)
 	{
-		if (it->second->Type == EStackItemType::Struct)
+		if (it->Key == nullptr) continue;
+
+		if (it->Value->Type == EStackItemType::Struct)
 		{
-			arr->Add(((ArrayStackItem*)it->second)->Clone());
+			arr->Add(((ArrayStackItem*)it->Value)->Clone());
 		}
 		else
 		{
-			arr->Add(it->second);
+			arr->Add(it->Value);
 		}
 	}
 }
 
 bool MapStackItem::Set(IStackItem* key, IStackItem* value)
 {
-	for (auto it = this->_dictionary.begin(); it != this->_dictionary.end(); ++it)
+	uint32 hash = key->GetHash();
+	auto it = this->_index.find(MapKey{ key, hash });
+
+	if (it != this->_index.end())
 	{
-		if (!it->first->Equals(key)) continue;
+		auto &entry = this->_entries[it->second];
 
-		auto v = it->second;
+		auto v = entry.Value;
 		if (v == value) return false;
 
 		StackItemHelper::UnclaimAndFree(v);
 
 		value->Claim();
-		it->second = value;
+		entry.Value = value;
 		return false;
 	}
 
 	key->Claim();
 	value->Claim();
 
-	this->_dictionary.emplace(key, value);
+	this->_index.emplace(MapKey{ key, hash }, static_cast<int32>(this->_entries.size()));
+	this->_entries.push_back({ key, value, hash });
+	this->GetCounter()->MemoryInc(EntrySize);
 	return true;
-}
\ No newline at end of file
+}
@@ -1,24 +1,76 @@
 #pragma once
 
-#include "IStackItem.h"
+#include "ICompoundStackItem.h"
 #include "ArrayStackItem.h"
-#include <map>
+#include <vector>
+#include <unordered_map>
 
-class MapStackItem : public IStackItem
+class MapStackItem final : public ICompoundStackItem
 {
 private:
 
-	std::map<IStackItem*, IStackItem*> _dictionary;
+	friend class CycleCollector;
+	friend class StackItemCopier;
+
+	// Removed entries keep their slot with a null key until the next compaction,
+	// so a removal doesn't move the entries after it
+
+	struct MapEntry
+	{
+		IStackItem* Key;
+		IStackItem* Value;
+		uint32 Hash;
+	};
+
+	// Index keys carry the hash of their item, so rehashing the table never computes it again
+
+	struct MapKey
+	{
+		IStackItem* Item;
+		uint32 Hash;
+	};
+
+	struct MapKeyHasher
+	{
+		inline std::size_t operator()(const MapKey &key) const
+		{
+			return key.Hash;
+		}
+	};
+
+	struct MapKeyComparer
+	{
+		inline bool operator()(const MapKey &a, const MapKey &b) const
+		{
+			return a.Item == b.Item || (a.Hash == b.Hash && a.Item->Equals(b.Item));
+		}
+	};
+
+	// Entries in insertion order, and the index of each key inside them
+
+	std::vector<MapEntry> _entries;
+	std::unordered_map<MapKey, int32, MapKeyHasher, MapKeyComparer> _index;
+	int32 _removed;
+
+	// Memory accounted for each entry: the entry, its index node and its bucket
+
+	static const int32 EntrySize = sizeof(MapEntry) + sizeof(std::pair<const MapKey, int32>) + 3 * sizeof(void*);
+
+	// Drop the removed entries, keeping the order of the others
+
+	void Compact();
 
 public:
 
 	// Converters
 
 	inline bool GetBoolean() { return true; }
-	inline BigInteger* GetBigInteger() { return nullptr; }
+	inline const BigInteger* GetBigInteger(BigInteger &temp) { return nullptr; }
 	inline bool GetInt32(int32 &ret) { return false; }
+	inline bool GetInt64(int64 &ret) { return false; }
 	inline int32 ReadByteArray(byte* output, int32 sourceIndex, int32 count) { return -1; }
 	inline int32 ReadByteArraySize() { return -1; }
+	inline int32 GetByteArrayView(const byte* &data) { return -1; }
 
 	void Clear();
 
@@ -31,7 +83,7 @@ public:
 
 	inline int32 Count()
 	{
-		return static_cast<int>(this->_dictionary.size());
+		return static_cast<int>(this->_entries.size()) - this->_removed;
 	}
 
 	bool Set(IStackItem* key, IStackItem* value);
@@ -39,19 +91,45 @@ public:
 	bool Remove(IStackItem* &key);
 	void FillKeys(ArrayStackItem* arr);
 	void FillValues(ArrayStackItem* arr);
-	IStackItem* GetKey(int32 index);
-	IStackItem* GetValue(int32 index);
+
+	inline IStackItem* GetKey(int32 index)
+	{
+		if (index < 0 || index >= this->Count()) return nullptr;
+		if (this->_removed > 0) this->Compact();
+
+		return this->_entries[index].Key;
+	}
+
+	inline IStackItem* GetValue(int32 index)
+	{
+		if (index < 0 || index >= this->Count()) return nullptr;
+		if (this->_removed > 0) this->Compact();
+
+		return this->_entries[index].Value;
+	}
+
+	// Hash
+
+	inline uint32 GetHash()
+	{
+		return (uint32)this->Type;
+	}
 
 	// Constructor & Destructor
 
 	inline MapStackItem(IStackItemCounter* counter) :
-		IStackItem(counter, EStackItemType::Map),
-		_dictionary(std::map<IStackItem*, IStackItem*>())
-	{ }
+		ICompoundStackItem(counter, EStackItemType::Map),
+		_entries(),
+		_index(),
+		_removed(0)
+	{
+		counter->MemoryInc(sizeof(MapStackItem));
+	}
 
 	inline ~MapStackItem()
 	{
 		this->Clear();
+		this->GetCounter()->MemoryDec(sizeof(MapStackItem));
 	}
 
 	// Serialize
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Types.h"
+
+// Temporary buffer, on the stack when it's big enough for the legal values
+
+template <class T, int32 N>
+class ScratchBuffer
+{
+private:
+
+	T _inline[N];
+	T* _data;
+
+public:
+
+	inline ScratchBuffer(int32 size) : _data(size <= N ? _inline : new T[size]) { }
+
+	inline ~ScratchBuffer()
+	{
+		if (this->_data != this->_inline)
+		{
+			delete[](this->_data);
+		}
+	}
+
+	inline operator T*() { return this->_data; }
+};
\ No newline at end of file
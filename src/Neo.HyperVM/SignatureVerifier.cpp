@@ -0,0 +1,278 @@
+#include "SignatureVerifier.h"
+#include "Crypto.h"
+#include "Limits.h"
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pairs of one CHECKMULTISIG. The signature i can only be tried with the keys i..i+(width-1),
+// any other key would leave too few keys for the rest of the signatures
+
+class VerifyJob
+{
+public:
+
+	static const byte PAIR_FREE = 0;
+	static const byte PAIR_CLAIMED = 1;
+	static const byte PAIR_INVALID = 2;
+	static const byte PAIR_VALID = 3;
+
+	const byte* Hash;
+	const byte** Signatures;
+	const int32* SignaturesL;
+	const byte** PubKeys;
+	const int32* PubKeysL;
+
+	int32 Width;
+
+	// Pairs by key, then by signature, so the first ones are those the walk needs first
+
+	std::vector<int32> Order;
+	std::vector<std::atomic<byte>> States;
+
+	std::atomic<int32> Next;
+	std::atomic<bool> Stop;
+
+	// Workers inside Run, and how many can join (guarded by the lock of the pool)
+
+	int32 Workers;
+	int32 MaxWorkers;
+
+	VerifyJob
+	(
+		const byte* hash,
+		const byte** signatures, const int32* signaturesL, int32 signaturesCount,
+		const byte** pubKeys, const int32* pubKeysL, int32 pubKeysCount,
+		int32 maxWorkers
+	) :
+		Hash(hash),
+		Signatures(signatures),
+		SignaturesL(signaturesL),
+		PubKeys(pubKeys),
+		PubKeysL(pubKeysL),
+		Width(pubKeysCount - signaturesCount + 1),
+		Order(),
+		States(signaturesCount * (pubKeysCount - signaturesCount + 1)),
+		Next(0),
+		Stop(false),
+		Workers(0),
+		MaxWorkers(maxWorkers)
+	{
+		for (auto &state : this->States)
+			state.store(PAIR_FREE);
+
+		for (int32 j = 0; j < pubKeysCount; ++j)
+			for (int32 i = j - this->Width + 1; i <= j; ++i)
+				if (i >= 0 && i < signaturesCount)
+					this->Order.push_back(this->IndexOf(i, j));
+	}
+
+	inline int32 IndexOf(int32 i, int32 j) const
+	{
+		return i * this->Width + (j - i);
+	}
+
+	inline bool Claim(int32 index)
+	{
+		byte expected = PAIR_FREE;
+		return this->States[index].compare_exchange_strong(expected, PAIR_CLAIMED);
+	}
+
+	inline bool Verify(int32 index)
+	{
+		int32 i = index / this->Width;
+		int32 j = i + index % this->Width;
+
+		// -1 (wrong lengths) counts as a match, like in the sequential walk
+
+		bool ret = Crypto::VerifyDigest(this->Hash, this->Signatures[i], this->SignaturesL[i], this->PubKeys[j], this->PubKeysL[j]) != 0;
+
+		this->States[index].store(ret ? PAIR_VALID : PAIR_INVALID);
+		return ret;
+	}
+
+	// Verify the free pairs in order, returns when all of them were claimed or the walk is over
+
+	template <class T>
+	inline void Run(T verified)
+	{
+		while (!this->Stop.load())
+		{
+			int32 next = this->Next.fetch_add(1);
+
+			if (next >= (int32)this->Order.size())
+			{
+				return;
+			}
+
+			if (this->Claim(this->Order[next]))
+			{
+				this->Verify(this->Order[next]);
+				verified();
+			}
+		}
+	}
+};
+
+// Workers shared by all the engines, started the first time they're needed. Each job takes at most
+// the threads that its engine asked for, the engine thread is one of them
+
+class VerifyPool
+{
+private:
+
+	std::mutex _lock;
+	std::condition_variable _work;
+	std::condition_variable _done;
+	std::list<VerifyJob*> _jobs;
+	int32 _threads;
+
+	void Notify()
+	{
+		// Empty lock, so the engine thread can't miss the result between its check and its wait
+
+		{
+			std::lock_guard<std::mutex> lock(this->_lock);
+		}
+
+		this->_done.notify_all();
+	}
+
+	void Work()
+	{
+		std::unique_lock<std::mutex> lock(this->_lock);
+
+		for (;;)
+		{
+			this->_work.wait(lock, [this]() { return !this->_jobs.empty(); });
+
+			auto job = this->_jobs.front();
+
+			if (++job->Workers >= job->MaxWorkers)
+			{
+				this->_jobs.pop_front();
+			}
+
+			lock.unlock();
+			job->Run([this]() { this->Notify(); });
+			lock.lock();
+
+			// Nothing left to claim, so the idle workers don't join it again
+
+			this->_jobs.remove(job);
+
+			--job->Workers;
+			this->_done.notify_all();
+		}
+	}
+
+public:
+
+	inline VerifyPool() : _threads(0) { }
+
+	bool Verify(VerifyJob &job, int32 signaturesCount, int32 pubKeysCount)
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->_lock);
+
+			for (; this->_threads < job.MaxWorkers; ++this->_threads)
+			{
+				std::thread(&VerifyPool::Work, this).detach();
+			}
+
+			this->_jobs.push_back(&job);
+		}
+
+		this->_work.notify_all();
+
+		bool ret = true;
+
+		for (int32 i = 0, j = 0; ret && i < signaturesCount && j < pubKeysCount;)
+		{
+			int32 index = job.IndexOf(i, j);
+			bool valid;
+
+			if (job.Claim(index))
+			{
+				valid = job.Verify(index);
+			}
+			else
+			{
+				std::unique_lock<std::mutex> lock(this->_lock);
+
+				this->_done.wait(lock, [&]() { return job.States[index].load() >= VerifyJob::PAIR_INVALID; });
+				valid = job.States[index].load() == VerifyJob::PAIR_VALID;
+			}
+
+			if (valid)
+				++i;
+
+			j++;
+
+			if (signaturesCount - i > pubKeysCount - j)
+			{
+				ret = false;
+				break;
+			}
+		}
+
+		// The job lives in the stack of the caller, it waits for the workers that are still verifying
+
+		job.Stop.store(true);
+
+		std::unique_lock<std::mutex> lock(this->_lock);
+
+		this->_jobs.remove(&job);
+		this->_done.wait(lock, [&]() { return job.Workers == 0; });
+
+		return ret;
+	}
+};
+
+bool SignatureVerifier::VerifyMultisig
+(
+	const byte* hash,
+	const byte** signatures, const int32* signaturesL, int32 signaturesCount,
+	const byte** pubKeys, const int32* pubKeysL, int32 pubKeysCount,
+	int32 threads
+)
+{
+	if (threads > MAX_VERIFICATION_THREADS)
+	{
+		threads = MAX_VERIFICATION_THREADS;
+	}
+
+	// One signature with one key is faster on this thread
+
+	if (threads > 1 && signaturesCount * (pubKeysCount - signaturesCount + 1) > 1)
+	{
+		// Never freed, the workers wait on it until the process ends
+
+		static VerifyPool* pool = new VerifyPool();
+
+		VerifyJob job(hash, signatures, signaturesL, signaturesCount, pubKeys, pubKeysL, pubKeysCount, threads - 1);
+
+		return pool->Verify(job, signaturesCount, pubKeysCount);
+	}
+
+	bool ret = true;
+
+	for (int32 i = 0, j = 0; ret && i < signaturesCount && j < pubKeysCount;)
+	{
+		if (Crypto::VerifyDigest(hash, signatures[i], signaturesL[i], pubKeys[j], pubKeysL[j]))
+			++i;
+
+		j++;
+
+		if (signaturesCount - i > pubKeysCount - j)
+		{
+			ret = false;
+			break;
+		}
+	}
+
+	return ret;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Types.h"
+
+class SignatureVerifier
+{
+public:
+
+	// Walk of CHECKMULTISIG over the SHA256 of the message: the signatures are matched with the keys
+	// in order, a key that doesn't match is skipped, and it stops when there aren't enough keys left.
+	// With more than one thread, the pairs that the walk can reach are verified ahead on the shared
+	// workers, and the walk reads their results, so it visits the same pairs with the same results
+
+	static bool VerifyMultisig
+	(
+		const byte* hash,
+		const byte** signatures, const int32* signaturesL, int32 signaturesCount,
+		const byte** pubKeys, const int32* pubKeysL, int32 pubKeysCount,
+		int32 threads
+	);
+};
\ No newline at end of file
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "IStackItem.h"
+#include "BoolStackItem.h"
+#include "ByteArrayStackItem.h"
+#include "IntegerStackItem.h"
+#include "InteropStackItem.h"
+
+// Dispatch on the item type for the hot conversions, so the calls are
+// resolved (and inlined) without using the vtable
+
+class StackItemConverter
+{
+public:
+
+	static inline bool GetBoolean(IStackItem* it)
+	{
+		switch (it->Type)
+		{
+		case EStackItemType::Bool: return ((BoolStackItem*)it)->GetBoolean();
+		case EStackItemType::Integer: return ((IntegerStackItem*)it)->GetBoolean();
+		case EStackItemType::ByteArray: return ((ByteArrayStackItem*)it)->GetBoolean();
+		default: return it->GetBoolean();
+		}
+	}
+
+	static inline bool GetInt32(IStackItem* it, int32 &ret)
+	{
+		switch (it->Type)
+		{
+		case EStackItemType::Bool: return ((BoolStackItem*)it)->GetInt32(ret);
+		case EStackItemType::Integer: return ((IntegerStackItem*)it)->GetInt32(ret);
+		case EStackItemType::ByteArray: return ((ByteArrayStackItem*)it)->GetInt32(ret);
+		default: return it->GetInt32(ret);
+		}
+	}
+
+	static inline bool GetInt64(IStackItem* it, int64 &ret)
+	{
+		switch (it->Type)
+		{
+		case EStackItemType::Bool: return ((BoolStackItem*)it)->GetInt64(ret);
+		case EStackItemType::Integer: return ((IntegerStackItem*)it)->GetInt64(ret);
+		case EStackItemType::ByteArray: return ((ByteArrayStackItem*)it)->GetInt64(ret);
+		default: return it->GetInt64(ret);
+		}
+	}
+
+	static inline const BigInteger* GetBigInteger(IStackItem* it, BigInteger &temp)
+	{
+		switch (it->Type)
+		{
+		case EStackItemType::Bool: return ((BoolStackItem*)it)->GetBigInteger(temp);
+		case EStackItemType::Integer: return ((IntegerStackItem*)it)->GetBigInteger(temp);
+		case EStackItemType::ByteArray: return ((ByteArrayStackItem*)it)->GetBigInteger(temp);
+		default: return it->GetBigInteger(temp);
+		}
+	}
+
+	static inline int32 ReadByteArraySize(IStackItem* it)
+	{
+		switch (it->Type)
+		{
+		case EStackItemType::Bool: return ((BoolStackItem*)it)->ReadByteArraySize();
+		case EStackItemType::Integer: return ((IntegerStackItem*)it)->ReadByteArraySize();
+		case EStackItemType::ByteArray: return ((ByteArrayStackItem*)it)->ReadByteArraySize();
+		default: return it->ReadByteArraySize();
+		}
+	}
+
+	static inline int32 ReadByteArray(IStackItem* it, byte* output, int32 sourceIndex, int32 count)
+	{
+		switch (it->Type)
+		{
+		case EStackItemType::Bool: return ((BoolStackItem*)it)->ReadByteArray(output, sourceIndex, count);
+		case EStackItemType::Integer: return ((IntegerStackItem*)it)->ReadByteArray(output, sourceIndex, count);
+		case EStackItemType::ByteArray: return ((ByteArrayStackItem*)it)->ReadByteArray(output, sourceIndex, count);
+		default: return it->ReadByteArray(output, sourceIndex, count);
+		}
+	}
+
+	static inline int32 GetByteArrayView(IStackItem* it, const byte* &data)
+	{
+		switch (it->Type)
+		{
+		case EStackItemType::Bool: return ((BoolStackItem*)it)->GetByteArrayView(data);
+		case EStackItemType::Integer: return ((IntegerStackItem*)it)->GetByteArrayView(data);
+		case EStackItemType::ByteArray: return ((ByteArrayStackItem*)it)->GetByteArrayView(data);
+		default: return it->GetByteArrayView(data);
+		}
+	}
+
+	// The int64 value only when it's cheap: the byte arrays longer than 8 bytes are never
+	// decoded here, the callers operate on their encoding instead
+
+	static inline bool GetSmallInt64(IStackItem* it, int64 &ret)
+	{
+		if (it->Type == EStackItemType::ByteArray && ((ByteArrayStackItem*)it)->ReadByteArraySize() > 8)
+		{
+			return false;
+		}
+
+		return GetInt64(it, ret);
+	}
+
+	// Numeric order of two items, from their int64 values or from their encodings,
+	// so nothing is decoded or allocated. False when one of them isn't a number
+
+	static inline bool CompareTo(IStackItem* a, IStackItem* b, int32 &ret)
+	{
+		int64 va, vb;
+
+		if (GetSmallInt64(a, va) && GetSmallInt64(b, vb))
+		{
+			ret = va < vb ? -1 : (va > vb ? +1 : 0);
+			return true;
+		}
+
+		const byte* da;
+		const byte* db;
+		int32 la = GetByteArrayView(a, da);
+		int32 lb = GetByteArrayView(b, db);
+
+		if (la < 0 || lb < 0)
+		{
+			return false;
+		}
+
+		ret = BigInteger::CompareEncoding(da, la, db, lb);
+		return true;
+	}
+
+	static inline bool Equals(IStackItem* a, IStackItem* b)
+	{
+		switch (a->Type)
+		{
+		case EStackItemType::Bool: return ((BoolStackItem*)a)->Equals(b);
+		case EStackItemType::Integer: return ((IntegerStackItem*)a)->Equals(b);
+		case EStackItemType::ByteArray: return ((ByteArrayStackItem*)a)->Equals(b);
+		default: return a->Equals(b);
+		}
+	}
+};
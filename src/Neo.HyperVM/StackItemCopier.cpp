@@ -0,0 +1,132 @@
+#include "StackItemCopier.h"
+#include "ArrayStackItem.h"
+#include "MapStackItem.h"
+#include "BoolStackItem.h"
+#include "IntegerStackItem.h"
+#include "ByteArrayStackItem.h"
+#include "InteropStackItem.h"
+
+IStackItem* StackItemCopier::Copy(IStackItem* item)
+{
+	if (item == nullptr) return nullptr;
+
+	auto it = this->_copies.find(item);
+
+	if (it != this->_copies.end())
+	{
+		return (IStackItem*)it->second;
+	}
+
+	IStackItem* ret = nullptr;
+
+	switch (item->Type)
+	{
+	case EStackItemType::Bool:
+	{
+		ret = new BoolStackItem(this->_counter, item->GetBoolean());
+		break;
+	}
+	case EStackItemType::Integer:
+	{
+		BigInteger temp;
+		ret = new IntegerStackItem(this->_counter, *item->GetBigInteger(temp));
+		break;
+	}
+	case EStackItemType::ByteArray:
+	{
+		int32 size = item->ReadByteArraySize();
+		byte* data = size > 0 ? new byte[size] : nullptr;
+
+		if (data != nullptr)
+		{
+			item->ReadByteArray(data, 0, size);
+		}
+
+		ret = new ByteArrayStackItem(this->_counter, data, size, true);
+		break;
+	}
+	case EStackItemType::Interop:
+	{
+		int32 size = item->GetSerializedSize();
+		byte* data = new byte[size > 0 ? size : 1];
+
+		size = item->Serialize(data, size);
+		ret = new InteropStackItem(this->_counter, data, size);
+
+		delete[](data);
+		break;
+	}
+	case EStackItemType::Array:
+	case EStackItemType::Struct:
+	{
+		auto arr = (ArrayStackItem*)item;
+		auto storage = this->_copies.find(arr->_storage);
+
+		if (storage != this->_copies.end())
+		{
+			// Another owner of the storage was copied before
+
+			ret = new ArrayStackItem(this->_counter, arr->Type, (ArrayStackItem::ArrayStorage*)storage->second);
+			break;
+		}
+
+		auto copy = new ArrayStackItem(this->_counter, arr->Type == EStackItemType::Struct);
+
+		// Registered before the children, they could reference it
+
+		this->_copies[item] = copy;
+		this->_copies[arr->_storage] = copy->_storage;
+
+		auto &items = arr->_storage->Items;
+		copy->_storage->Items.reserve(items.size());
+
+		for (int32 x = 0, m = (int32)items.size(); x < m; ++x)
+		{
+			int64 slot = items[x];
+
+			if (!ArrayStackItem::IsPacked(slot))
+			{
+				auto child = this->Copy(ArrayStackItem::ToItem(slot));
+
+				if (child != nullptr)
+					child->Claim();
+
+				slot = ArrayStackItem::FromItem(child);
+			}
+
+			copy->_storage->Items.push_back(slot);
+		}
+
+		this->_counter->MemoryInc(items.size() * ArrayStackItem::SlotSize);
+		return copy;
+	}
+	case EStackItemType::Map:
+	{
+		auto map = (MapStackItem*)item;
+		auto copy = new MapStackItem(this->_counter);
+
+		this->_copies[item] = copy;
+
+		for (auto entry = map->_entries.begin(); entry != map->_entries.end(); ++entry)
+		{
+			if (entry->Key == nullptr) continue;
+
+			copy->Set(this->Copy(entry->Key), this->Copy(entry->Value));
+		}
+
+		return copy;
+	}
+	default: return nullptr;
+	}
+
+	this->_copies[item] = ret;
+	return ret;
+}
+
+void StackItemCopier::CopyCompounds(IStackItemCounter* counter)
+{
+	for (auto item = counter->_compounds; item != nullptr; item = item->_nextCompound)
+	{
+		this->Copy(item);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Types.h"
+#include "IStackItem.h"
+#include "IStackItemCounter.h"
+#include <unordered_map>
+
+class StackItemCopier
+{
+private:
+
+	IStackItemCounter* _counter;
+
+	// Copies of the items and of the shared array storages, the references between them are kept
+
+	std::unordered_map<void*, void*> _copies;
+
+public:
+
+	// Copy an item and everything that it references into the counter
+
+	IStackItem* Copy(IStackItem* item);
+
+	// Copy the compound items that aren't referenced from the stacks (cycles pending of collection or held by the host)
+
+	void CopyCompounds(IStackItemCounter* counter);
+
+	// Constructor
+
+	inline StackItemCopier(IStackItemCounter* counter) :
+		_counter(counter),
+		_copies()
+	{ }
+};
\ No newline at end of file
@@ -11,4 +11,19 @@ public:
 	static void Free(IStackItem* &itemA, IStackItem* &itemB, IStackItem* &itemC);
 
 	static void UnclaimAndFree(IStackItem* &item);
+
+	// FNV-1a over the byte encoding, used by the map index
+
+	static inline uint32 Hash(const byte* data, int32 length)
+	{
+		uint32 hash = 2166136261U;
+
+		for (int32 x = 0; x < length; ++x)
+		{
+			hash ^= data[x];
+			hash *= 16777619U;
+		}
+
+		return hash;
+	}
 };
\ No newline at end of file
@@ -1,85 +1,219 @@
 #pragma once
 
 #include "IStackItem.h"
-#include "Stack.h"
+#include "ValueStack.h"
 #include "StackItemHelper.h"
 
 class StackItems
 {
-	Stack<IStackItem> _stack;
+private:
+
+	friend class ValueStack;
+
+	// Own storage, used when the stack is not a window of a shared value stack
+
+	ValueStack _own;
+	ValueStack* _values;
+
+	// Window [_base, _top) inside the value stack
+
+	int32 _base;
+	int32 _top;
+	bool _isLinked;
+
+	StackItems* _prev;
+	StackItems* _next;
+
+	inline int32 GetPosition(int32 index) const
+	{
+		if (index < 0)
+		{
+			index += this->Count();
+		}
+
+		if (index < 0 || index >= this->Count())
+		{
+			return -1;
+		}
+
+		return this->_top - index - 1;
+	}
 
 public:
 
 	inline int32 Count() const
 	{
-		return this->_stack.Count();
+		return this->_top - this->_base;
+	}
+
+	inline ValueStack* GetValueStack() const
+	{
+		return this->_values;
 	}
 
 	inline IStackItem* Top() const
 	{
-		return this->_stack.Top();
+		if (this->_top == this->_base)
+		{
+			return nullptr;
+		}
+
+		return this->_values->_items[this->_top - 1];
 	}
 	
 	inline IStackItem* Peek(int32 index) const
 	{
-		return this->_stack.Peek(index);
+		int32 pos = this->GetPosition(index);
+
+		if (pos < 0)
+		{
+			return nullptr;
+		}
+
+		return this->_values->_items[pos];
 	}
 
 	inline void Push(IStackItem* it)
 	{
 		it->Claim();
-		this->_stack.Push(it);
+
+		if (this->_next == nullptr && this->_values->_size < this->_values->_capacity)
+		{
+			// Top window, just append
+
+			this->_values->_items[this->_top++] = it;
+			this->_values->_size++;
+		}
+		else
+		{
+			this->_values->Open(this, this->_top, 1);
+			this->_values->_items[this->_top - 1] = it;
+		}
 	}
 
 	inline void Insert(int32 index, IStackItem* it)
 	{
 		it->Claim();
-		this->_stack.Insert(index, it);
+
+		if (index < 0 || index > this->Count())
+		{
+			return;
+		}
+
+		int32 pos = this->_top - index;
+
+		this->_values->Open(this, pos, 1);
+		this->_values->_items[pos] = it;
 	}
 
 	inline IStackItem* Remove(int32 index)
 	{
-		auto it = this->_stack.Pop(index);
-		
+		int32 pos = this->GetPosition(index);
+
+		if (pos < 0)
+		{
+			return nullptr;
+		}
+
+		auto it = this->_values->_items[pos];
+		this->_values->Close(this, pos, 1);
+
 		if (it != nullptr) it->UnClaim();
 
 		return it;
 	}
 
-	inline void Drop()
-	{
-		auto it = this->_stack.Pop();
-		StackItemHelper::UnclaimAndFree(it);
-	}
-
 	inline IStackItem* Pop()
 	{
-		auto it = this->_stack.Pop();
+		if (this->_top == this->_base)
+		{
+			return nullptr;
+		}
+
+		auto it = this->_values->_items[this->_top - 1];
+
+		if (this->_next == nullptr)
+		{
+			// Top window, just remove it
+
+			this->_top--;
+			this->_values->_size--;
+		}
+		else
+		{
+			this->_values->Close(this, this->_top - 1, 1);
+		}
+
 		if (it != nullptr) it->UnClaim();
 
 		return it;
 	}
 
+	inline void Drop()
+	{
+		auto it = this->Pop();
+		StackItemHelper::Free(it);
+	}
+
 	inline void Clear()
 	{
-		for (int32 x = 0, count = this->_stack.Count(); x < count; x++)
+		for (int32 x = this->_base; x < this->_top; x++)
 		{
-			auto ptr = this->_stack.Peek(x);
+			auto ptr = this->_values->_items[x];
 			StackItemHelper::UnclaimAndFree(ptr);
 		}
 
-		this->_stack.Clear();
+		this->_values->Close(this, this->_base, this->Count());
 	}
 
 	inline void SendTo(StackItems* stack, int32 count)
 	{
 		if (stack == nullptr) return;
 
-		this->_stack.SendTo(&stack->_stack, count);
+		this->_values->Send(this, stack, count);
 	}
 
-	inline ~StackItems()
+	// Window
+
+	inline void Link()
+	{
+		this->_values->Link(this);
+	}
+
+	inline void Unlink()
 	{
 		this->Clear();
+		this->_values->Unlink(this);
+	}
+
+	// Constructor & Destructor
+
+	inline StackItems() :
+		_own(0),
+		_values(&_own),
+		_base(0),
+		_top(0),
+		_isLinked(false),
+		_prev(nullptr),
+		_next(nullptr)
+	{
+		this->_values->Link(this);
+	}
+
+	inline StackItems(ValueStack* values) :
+		_own(0),
+		_values(values),
+		_base(0),
+		_top(0),
+		_isLinked(false),
+		_prev(nullptr),
+		_next(nullptr)
+	{
+		this->_values->Link(this);
+	}
+
+	inline ~StackItems()
+	{
+		this->Unlink();
 	}
-};
\ No newline at end of file
+};
@@ -0,0 +1,169 @@
+#include "ValueStack.h"
+#include "StackItems.h"
+#include <algorithm>
+#include <string.h>
+
+void ValueStack::EnsureCapacity(int32 min)
+{
+	if (this->_capacity >= min)
+	{
+		return;
+	}
+
+	int32 num = (this->_capacity == 0) ? 4 : (this->_capacity * 2);
+
+	if (num < min)
+	{
+		num = min;
+	}
+
+	auto array = new IStackItem*[num];
+
+	if (this->_size > 0)
+	{
+		memcpy(array, this->_items, this->_size * sizeof(IStackItem*));
+	}
+
+	if (this->_items != nullptr)
+	{
+		delete[](this->_items);
+	}
+
+	this->_items = array;
+	this->_capacity = num;
+}
+
+// Windows
+
+void ValueStack::Link(StackItems* window)
+{
+	if (window->_isLinked) return;
+
+	window->_base = window->_top = this->_size;
+	window->_prev = this->_last;
+	window->_next = nullptr;
+	window->_isLinked = true;
+
+	if (this->_last != nullptr)
+	{
+		this->_last->_next = window;
+	}
+	else
+	{
+		this->_first = window;
+	}
+
+	this->_last = window;
+}
+
+void ValueStack::Unlink(StackItems* window)
+{
+	if (!window->_isLinked) return;
+
+	this->Close(window, window->_base, window->_top - window->_base);
+
+	if (window->_prev != nullptr) window->_prev->_next = window->_next;
+	else this->_first = window->_next;
+
+	if (window->_next != nullptr) window->_next->_prev = window->_prev;
+	else this->_last = window->_prev;
+
+	window->_prev = window->_next = nullptr;
+	window->_isLinked = false;
+}
+
+void ValueStack::Open(StackItems* window, int32 index, int32 count)
+{
+	if (count <= 0) return;
+
+	this->EnsureCapacity(this->_size + count);
+
+	if (index < this->_size)
+	{
+		memmove(&this->_items[index + count], &this->_items[index], (this->_size - index) * sizeof(IStackItem*));
+	}
+
+	this->_size += count;
+	window->_top += count;
+
+	for (auto next = window->_next; next != nullptr; next = next->_next)
+	{
+		next->_base += count;
+		next->_top += count;
+	}
+}
+
+void ValueStack::Close(StackItems* window, int32 index, int32 count)
+{
+	if (count <= 0) return;
+
+	if (index + count < this->_size)
+	{
+		memmove(&this->_items[index], &this->_items[index + count], (this->_size - index - count) * sizeof(IStackItem*));
+	}
+
+	this->_size -= count;
+	window->_top -= count;
+
+	for (auto next = window->_next; next != nullptr; next = next->_next)
+	{
+		next->_base -= count;
+		next->_top -= count;
+	}
+}
+
+void ValueStack::Send(StackItems* from, StackItems* to, int32 count)
+{
+	int32 available = from->Count();
+
+	if (count == -1 || count > available)
+	{
+		count = available;
+	}
+
+	if (count <= 0 || from == to) return;
+
+	if (to->_values == this)
+	{
+		if (to == from->_next)
+		{
+			// Call: [from | sent][to] => [from][to | sent]
+
+			if (to->_top > to->_base)
+			{
+				std::rotate(&this->_items[from->_top - count], &this->_items[from->_top], &this->_items[to->_top]);
+			}
+
+			from->_top -= count;
+			to->_base -= count;
+			return;
+		}
+
+		if (to == from->_prev)
+		{
+			// Return: [to][from | sent] => [to | sent][from]
+
+			if (count < available)
+			{
+				std::rotate(&this->_items[from->_base], &this->_items[from->_top - count], &this->_items[from->_top]);
+			}
+
+			from->_base += count;
+			to->_top += count;
+			return;
+		}
+	}
+
+	// Not adjacent windows, copy the items
+
+	auto items = new IStackItem*[count];
+	memcpy(items, &this->_items[from->_top - count], count * sizeof(IStackItem*));
+
+	this->Close(from, from->_top - count, count);
+
+	int32 index = to->_top;
+	to->_values->Open(to, index, count);
+	memcpy(&to->_values->_items[index], items, count * sizeof(IStackItem*));
+
+	delete[](items);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Types.h"
+
+class IStackItem;
+class StackItems;
+
+class ValueStack
+{
+private:
+
+	friend class StackItems;
+
+	IStackItem** _items;
+	int32 _size;
+	int32 _capacity;
+
+	// Windows in the same order than their items
+
+	StackItems* _first;
+	StackItems* _last;
+
+	void EnsureCapacity(int32 min);
+
+	void Link(StackItems* window);
+	void Unlink(StackItems* window);
+
+	void Open(StackItems* window, int32 index, int32 count);
+	void Close(StackItems* window, int32 index, int32 count);
+	void Send(StackItems* from, StackItems* to, int32 count);
+
+public:
+
+	inline int32 Count() const
+	{
+		return this->_size;
+	}
+
+	// Constructor & Destructor
+
+	inline ValueStack(int32 capacity) :
+		_items(capacity > 0 ? new IStackItem*[capacity] : nullptr),
+		_size(0),
+		_capacity(capacity),
+		_first(nullptr),
+		_last(nullptr)
+	{ }
+
+	inline ~ValueStack()
+	{
+		if (this->_items != nullptr)
+		{
+			delete[](this->_items);
+			this->_items = nullptr;
+		}
+	}
+};
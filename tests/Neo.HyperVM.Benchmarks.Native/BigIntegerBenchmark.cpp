@@ -0,0 +1,488 @@
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <openssl/bn.h>
+
+#include "BigInteger.h"
+
+// Native BigInteger benchmark, the results are written as JSON
+// (usage: Neo.HyperVM.Benchmark [iterations] or Neo.HyperVM.Benchmark --diff [iterations] [seed])
+
+// Encoding of any result: a product of two legal operands or a shift of a legal operand, plus the sign byte
+
+const int32 MaxBytes = 2 * MAX_BIGINTEGER_SIZE + 64;
+
+const int32 PoolSize = 64;
+
+const int32 Buckets[] = { 1, 2, 4, 8, 16, 24, 32 };
+const int32 BucketsCount = sizeof(Buckets) / sizeof(int32);
+
+enum class SignMix { Positive, Negative, Mixed };
+
+const char* SignMixNames[] = { "positive", "negative", "mixed" };
+
+enum class Operation { FromBytes, ToByteArray, Add, Sub, Mul, Div, Mod, Shl, Shr, CompareTo, ToInt32 };
+
+const int32 OperationsCount = 11;
+
+const char* OperationNames[] = { "FromBytes", "ToByteArray", "Add", "Sub", "Mul", "Div", "Mod", "Shl", "Shr", "CompareTo", "ToInt32" };
+
+class Random
+{
+private:
+
+	uint64 _state;
+
+public:
+
+	inline Random(uint64 seed) : _state(seed == 0 ? 0x9E3779B97F4A7C15ULL : seed) { }
+
+	inline uint64 Next()
+	{
+		// xorshift64*
+
+		this->_state ^= this->_state >> 12;
+		this->_state ^= this->_state << 25;
+		this->_state ^= this->_state >> 27;
+		return this->_state * 0x2545F4914F6CDD1DULL;
+	}
+
+	inline uint32 Next(uint32 max)
+	{
+		return (uint32)(this->Next() % max);
+	}
+};
+
+// Keeps the compiler from dropping the measured work
+
+volatile int64 Sink = 0;
+
+// Benchmark
+
+class Pool
+{
+public:
+
+	byte Data[PoolSize][MAX_BIGINTEGER_SIZE];
+	BigInteger Left[PoolSize];
+	BigInteger Right[PoolSize];
+	int32 Shift[PoolSize];
+	int32 Length;
+
+	void Fill(Random &rnd, int32 length, SignMix mix)
+	{
+		this->Length = length;
+
+		for (int32 x = 0; x < PoolSize; ++x)
+		{
+			for (int32 y = 0; y < length; ++y)
+				this->Data[x][y] = (byte)rnd.Next();
+
+			// The high byte is never zero, so the values use the whole bucket
+
+			bool negative = mix == SignMix::Negative || (mix == SignMix::Mixed && rnd.Next(2) == 0);
+			byte high = (byte)(1 + rnd.Next(0x7E));
+
+			this->Data[x][length - 1] = negative ? (byte)(0xFF - high) : high;
+			this->Shift[x] = 1 + (int32)rnd.Next(64);
+		}
+
+		for (int32 x = 0; x < PoolSize; ++x)
+		{
+			this->Left[x] = BigInteger(this->Data[x], length);
+			this->Right[x] = BigInteger(this->Data[(x + 1) % PoolSize], length);
+		}
+	}
+};
+
+template <class F>
+double Measure(int32 iterations, F call)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	for (int32 x = 0; x < iterations; ++x)
+	{
+		for (int32 i = 0; i < PoolSize; ++i)
+			call(i);
+	}
+
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	return std::chrono::duration<double, std::nano>(elapsed).count() / ((double)iterations * PoolSize);
+}
+
+double Measure(Operation op, Pool &pool, int32 iterations)
+{
+	BigInteger ret;
+	byte output[MaxBytes];
+
+	switch (op)
+	{
+	case Operation::FromBytes: return Measure(iterations, [&](int32 i)
+	{
+		BigInteger value(pool.Data[i], pool.Length);
+		Sink += value.GetSign();
+	});
+	case Operation::ToByteArray: return Measure(iterations, [&](int32 i)
+	{
+		// The copy drops the cached size, like a fresh result
+
+		BigInteger value(pool.Left[i]);
+		Sink += value.ToByteArray(output, value.ToByteArraySize());
+	});
+	case Operation::Add: return Measure(iterations, [&](int32 i) { pool.Left[i].Add(pool.Right[i], ret); Sink += ret.GetSign(); });
+	case Operation::Sub: return Measure(iterations, [&](int32 i) { pool.Left[i].Sub(pool.Right[i], ret); Sink += ret.GetSign(); });
+	case Operation::Mul: return Measure(iterations, [&](int32 i) { pool.Left[i].Mul(pool.Right[i], ret); Sink += ret.GetSign(); });
+	case Operation::Div: return Measure(iterations, [&](int32 i) { pool.Left[i].Div(pool.Right[i], ret); Sink += ret.GetSign(); });
+	case Operation::Mod: return Measure(iterations, [&](int32 i) { pool.Left[i].Mod(pool.Right[i], ret); Sink += ret.GetSign(); });
+	case Operation::Shl: return Measure(iterations, [&](int32 i) { pool.Left[i].Shl(pool.Shift[i], ret); Sink += ret.GetSign(); });
+	case Operation::Shr: return Measure(iterations, [&](int32 i) { pool.Left[i].Shr(pool.Shift[i], ret); Sink += ret.GetSign(); });
+	case Operation::CompareTo: return Measure(iterations, [&](int32 i) { Sink += pool.Left[i].CompareTo(pool.Right[i]); });
+	case Operation::ToInt32: return Measure(iterations, [&](int32 i)
+	{
+		int32 value = 0;
+		Sink += pool.Left[i].ToInt32(value) ? value : 0;
+	});
+	}
+
+	return 0;
+}
+
+int32 Benchmark(int32 iterations)
+{
+	Random rnd(1);
+	Pool* pool = new Pool();
+	bool first = true;
+
+	printf("{\n  \"benchmark\": \"BigInteger\",\n  \"iterations\": %d,\n  \"pool\": %d,\n  \"results\": [\n", iterations, PoolSize);
+
+	for (int32 b = 0; b < BucketsCount; ++b)
+	{
+		for (int32 s = 0; s < 3; ++s)
+		{
+			pool->Fill(rnd, Buckets[b], (SignMix)s);
+
+			for (int32 o = 0; o < OperationsCount; ++o)
+			{
+				double ns = Measure((Operation)o, *pool, iterations);
+
+				printf("%s    { \"operation\": \"%s\", \"bytes\": %d, \"sign\": \"%s\", \"ns\": %.2f }",
+					first ? "" : ",\n", OperationNames[o], Buckets[b], SignMixNames[s], ns);
+
+				first = false;
+			}
+		}
+	}
+
+	printf("\n  ]\n}\n");
+
+	delete(pool);
+	return 0;
+}
+
+// Differential against OpenSSL's BIGNUM
+
+class Reference
+{
+public:
+
+	// Little endian two's complement, as BigInteger
+
+	static BIGNUM* Decode(const byte* data, int32 length)
+	{
+		BIGNUM* ret = BN_new();
+
+		if (length == 0)
+		{
+			BN_zero(ret);
+			return ret;
+		}
+
+		byte bigEndian[MaxBytes];
+
+		for (int32 x = 0; x < length; ++x)
+			bigEndian[x] = data[length - 1 - x];
+
+		BN_bin2bn(bigEndian, length, ret);
+
+		if ((data[length - 1] & 0x80) != 0)
+		{
+			BIGNUM* range = BN_new();
+
+			BN_one(range);
+			BN_lshift(range, range, 8 * length);
+			BN_sub(ret, ret, range);
+			BN_free(range);
+		}
+
+		return ret;
+	}
+
+	static int32 Encode(const BIGNUM* value, byte* output)
+	{
+		if (BN_is_zero(value))
+		{
+			output[0] = 0;
+			return 1;
+		}
+
+		BIGNUM* t = BN_new();
+		int32 length = BN_num_bytes(value);
+
+		if (!BN_is_negative(value))
+		{
+			BN_copy(t, value);
+
+			if (BN_is_bit_set(value, 8 * length - 1))
+				++length;
+		}
+		else
+		{
+			// 2^(8 * length) + value, with one byte more when the sign bit is clear
+
+			for (;; ++length)
+			{
+				BN_one(t);
+				BN_lshift(t, t, 8 * length);
+				BN_add(t, t, value);
+
+				if (BN_is_bit_set(t, 8 * length - 1)) break;
+			}
+		}
+
+		byte bigEndian[MaxBytes];
+		int32 l = BN_num_bytes(t);
+
+		memset(bigEndian, 0, length);
+		BN_bn2bin(t, bigEndian + length - l);
+		BN_free(t);
+
+		for (int32 x = 0; x < length; ++x)
+			output[x] = bigEndian[length - 1 - x];
+
+		return length;
+	}
+
+	static void Shr(BIGNUM* ret, const BIGNUM* value, int32 shift)
+	{
+		// Rounds toward negative infinity, as BigInteger
+
+		if (!BN_is_negative(value))
+		{
+			BN_rshift(ret, value, shift);
+			return;
+		}
+
+		BIGNUM* round = BN_new();
+
+		BN_one(round);
+		BN_lshift(round, round, shift);
+		BN_sub_word(round, 1);
+		BN_copy(ret, value);
+		BN_set_negative(ret, 0);
+		BN_add(ret, ret, round);
+		BN_rshift(ret, ret, shift);
+		BN_set_negative(ret, 1);
+		BN_free(round);
+	}
+
+	static bool ToInt32(const BIGNUM* value, int32 &ret)
+	{
+		if (BN_num_bits(value) > 32)
+		{
+			return false;
+		}
+
+		int64 v = (int64)BN_get_word(value);
+
+		if (BN_is_negative(value)) v = -v;
+
+		if (v < -0x80000000LL || v > 0x7FFFFFFFLL)
+		{
+			return false;
+		}
+
+		ret = (int32)v;
+		return true;
+	}
+};
+
+class Differential
+{
+private:
+
+	Random _rnd;
+	BN_CTX* _ctx;
+
+	int32 _cases[OperationsCount];
+	int32 _failures[OperationsCount];
+
+	void RandomBytes(byte* data, int32 &length)
+	{
+		// Edge bytes around the sign bit and the limb boundaries are more common
+
+		length = (int32)this->_rnd.Next(MAX_BIGINTEGER_SIZE + 1);
+
+		for (int32 x = 0; x < length; ++x)
+		{
+			switch (this->_rnd.Next(6))
+			{
+			case 0: data[x] = 0x00; break;
+			case 1: data[x] = 0xFF; break;
+			case 2: data[x] = 0x80; break;
+			case 3: data[x] = 0x7F; break;
+			default: data[x] = (byte)this->_rnd.Next(); break;
+			}
+		}
+	}
+
+	static bool Equals(const BigInteger &actual, const BIGNUM* expected)
+	{
+		byte a[MaxBytes], e[MaxBytes];
+
+		int32 al = actual.ToByteArray(a, actual.ToByteArraySize());
+		int32 el = Reference::Encode(expected, e);
+
+		return al == el && memcmp(a, e, al) == 0;
+	}
+
+	inline void Check(Operation op, const BigInteger &actual, const BIGNUM* expected)
+	{
+		this->Check(op, Equals(actual, expected));
+	}
+
+	void Check(Operation op, bool ok)
+	{
+		++this->_cases[(int32)op];
+
+		if (!ok)
+		{
+			++this->_failures[(int32)op];
+		}
+	}
+
+public:
+
+	inline Differential(uint64 seed) : _rnd(seed), _ctx(BN_CTX_new())
+	{
+		for (int32 x = 0; x < OperationsCount; ++x)
+		{
+			this->_cases[x] = 0;
+			this->_failures[x] = 0;
+		}
+	}
+
+	inline ~Differential()
+	{
+		BN_CTX_free(this->_ctx);
+	}
+
+	void Run()
+	{
+		byte da[MAX_BIGINTEGER_SIZE], db[MAX_BIGINTEGER_SIZE];
+		int32 la, lb;
+
+		this->RandomBytes(da, la);
+		this->RandomBytes(db, lb);
+
+		BigInteger a(da, la), b(db, lb), ret;
+		BIGNUM* ra = Reference::Decode(da, la);
+		BIGNUM* rb = Reference::Decode(db, lb);
+		BIGNUM* r = BN_new();
+
+		this->Check(Operation::FromBytes, a, ra);
+
+		BigInteger copy(a);
+		this->Check(Operation::ToByteArray, copy, ra);
+
+		a.Add(b, ret);
+		BN_add(r, ra, rb);
+		this->Check(Operation::Add, ret, r);
+
+		a.Sub(b, ret);
+		BN_sub(r, ra, rb);
+		this->Check(Operation::Sub, ret, r);
+
+		a.Mul(b, ret);
+		BN_mul(r, ra, rb, this->_ctx);
+		this->Check(Operation::Mul, ret, r);
+
+		if (BN_is_zero(rb))
+		{
+			this->Check(Operation::Div, !a.Div(b, ret));
+			this->Check(Operation::Mod, !a.Mod(b, ret));
+		}
+		else
+		{
+			// Truncated division, the remainder takes the sign of the dividend
+
+			bool ok = a.Div(b, ret);
+			BN_div(r, nullptr, ra, rb, this->_ctx);
+			this->Check(Operation::Div, ok && Equals(ret, r));
+
+			ok = a.Mod(b, ret);
+			BN_div(nullptr, r, ra, rb, this->_ctx);
+			this->Check(Operation::Mod, ok && Equals(ret, r));
+		}
+
+		int32 shift = (int32)this->_rnd.Next(300);
+
+		a.Shl(shift, ret);
+		BN_lshift(r, ra, shift);
+		this->Check(Operation::Shl, ret, r);
+
+		a.Shr(shift, ret);
+		Reference::Shr(r, ra, shift);
+		this->Check(Operation::Shr, ret, r);
+
+		int32 cmp = a.CompareTo(b);
+		this->Check(Operation::CompareTo, (cmp > 0) - (cmp < 0) == BN_cmp(ra, rb));
+
+		int32 actual = 0, expected = 0;
+		bool fits = a.ToInt32(actual);
+		this->Check(Operation::ToInt32, fits == Reference::ToInt32(ra, expected) && (!fits || actual == expected));
+
+		BN_free(ra);
+		BN_free(rb);
+		BN_free(r);
+	}
+
+	int32 Report(int32 iterations, uint64 seed)
+	{
+		int32 failures = 0;
+
+		printf("{\n  \"differential\": \"BigInteger\",\n  \"reference\": \"OpenSSL BIGNUM\",\n  \"iterations\": %d,\n  \"seed\": %llu,\n  \"results\": [\n",
+			iterations, (unsigned long long)seed);
+
+		for (int32 o = 0; o < OperationsCount; ++o)
+		{
+			printf("%s    { \"operation\": \"%s\", \"cases\": %d, \"failures\": %d }",
+				o == 0 ? "" : ",\n", OperationNames[o], this->_cases[o], this->_failures[o]);
+
+			failures += this->_failures[o];
+		}
+
+		printf("\n  ],\n  \"failures\": %d\n}\n", failures);
+
+		return failures == 0 ? 0 : 1;
+	}
+};
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1 && strcmp(argv[1], "--diff") == 0)
+	{
+		int32 iterations = argc > 2 ? atoi(argv[2]) : 100000;
+		uint64 seed = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1;
+
+		Differential diff(seed);
+
+		for (int32 x = 0; x < iterations; ++x)
+			diff.Run();
+
+		return diff.Report(iterations, seed);
+	}
+
+	return Benchmark(argc > 1 ? atoi(argv[1]) : 10000);
+}
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "Tests.h"
+#include "BigInteger.h"
+#include "BigIntegerBuilder.h"
+
+// Randomized differential test of the BigInteger arithmetic against BigIntegerBuilder,
+// the reference implementation ported from .NET
+
+enum class Operation { Add, Sub, Mul, Div, Mod };
+
+static const char* OperationNames[] = { "Add", "Sub", "Mul", "Div", "Mod" };
+
+// Bigger than a legal value, so the heap fallbacks are exercised too
+
+static const int32 MaxLimbs = 2 * (MAX_BIGINTEGER_SIZE / 4) + 4;
+
+// Encoding of a product of two operands, plus the sign byte
+
+static const int32 MaxBytes = 2 * MaxLimbs * 4 + 1;
+
+class Operand
+{
+public:
+
+	uint32 Limbs[MaxLimbs];
+	int32 Length;
+	bool Negative;
+
+	// BigInteger representation, as BigIntegerBuilder reads it
+
+	int32 Sign;
+	uint32* Bits;
+	int32 BitsSize;
+
+	void Randomize(Random &rnd)
+	{
+		// Short values are more common, the edge limbs stress the carries and the quotient estimation
+
+		this->Length = (int32)(rnd.Next(4) == 0 ? rnd.Next(MaxLimbs + 1) : rnd.Next(MAX_BIGINTEGER_SIZE / 4 + 2));
+		this->Negative = rnd.Next(2) == 0;
+
+		for (int32 x = 0; x < this->Length; ++x)
+		{
+			switch (rnd.Next(6))
+			{
+			case 0: this->Limbs[x] = 0; break;
+			case 1: this->Limbs[x] = 0xFFFFFFFF; break;
+			case 2: this->Limbs[x] = 0x80000000; break;
+			case 3: this->Limbs[x] = 1; break;
+			default: this->Limbs[x] = (uint32)rnd.Next(); break;
+			}
+		}
+
+		this->Update();
+	}
+
+	void Update()
+	{
+		while (this->Length > 0 && this->Limbs[this->Length - 1] == 0)
+			--this->Length;
+
+		if (this->Length == 0)
+		{
+			this->Sign = 0;
+			this->Bits = nullptr;
+			this->BitsSize = 0;
+		}
+		else if (this->Length == 1 && this->Limbs[0] <= 0x7FFFFFFF)
+		{
+			this->Sign = this->Negative ? -(int32)this->Limbs[0] : (int32)this->Limbs[0];
+			this->Bits = nullptr;
+			this->BitsSize = 0;
+		}
+		else
+		{
+			this->Sign = this->Negative ? -1 : +1;
+			this->Bits = this->Limbs;
+			this->BitsSize = this->Length;
+		}
+	}
+
+	inline BigInteger ToBigInteger()
+	{
+		return BigInteger(this->Limbs, this->Length, this->Negative);
+	}
+};
+
+static BigInteger Expected(Operation op, Operand &a, Operand &b)
+{
+	BigInteger ia = a.ToBigInteger();
+	BigInteger ib = b.ToBigInteger();
+
+	if ((op == Operation::Add || op == Operation::Sub) && (ia.GetSign() == 0 || ib.GetSign() == 0))
+	{
+		BigInteger ret;
+
+		if (ib.GetSign() == 0) ret = ia;
+		else if (op == Operation::Add) ret = ib;
+		else ib.Negate(ret);
+
+		return ret;
+	}
+
+	int32 sign1 = +1;
+	int32 sign2 = op == Operation::Sub ? -1 : +1;
+
+	// Div and Mul take the sign of both operands, Mod the sign of the dividend
+
+	BigIntegerBuilder reg1(a.Sign, a.Bits, a.BitsSize, sign1);
+	BigIntegerBuilder reg2(b.Sign, b.Bits, b.BitsSize, op == Operation::Div || op == Operation::Mul ? sign1 : sign2);
+
+	switch (op)
+	{
+	case Operation::Add:
+	case Operation::Sub:
+	{
+		if (sign1 == sign2)
+			reg1.Add(reg2);
+		else
+			reg1.Sub(sign1, reg2);
+		break;
+	}
+	case Operation::Mul: reg1.Mul(reg2); break;
+	case Operation::Div: reg1.Div(reg2); break;
+	case Operation::Mod: reg1.Mod(reg2); break;
+	}
+
+	int32 bitSize;
+	uint32* bits;
+	reg1.GetInteger(sign1, bits, bitSize);
+
+	if (bits == nullptr)
+	{
+		return BigInteger(sign1);
+	}
+
+	return BigInteger(bits, bitSize, sign1 < 0);
+}
+
+static bool Compute(Operation op, const BigInteger &a, const BigInteger &b, BigInteger &ret)
+{
+	switch (op)
+	{
+	case Operation::Add: a.Add(b, ret); return true;
+	case Operation::Sub: a.Sub(b, ret); return true;
+	case Operation::Mul: a.Mul(b, ret); return true;
+	case Operation::Div: return a.Div(b, ret);
+	case Operation::Mod: return a.Mod(b, ret);
+	}
+
+	return false;
+}
+
+static bool Equals(const BigInteger &a, const BigInteger &b)
+{
+	byte da[MaxBytes], db[MaxBytes];
+
+	int32 la = a.ToByteArraySize();
+	int32 lb = b.ToByteArraySize();
+
+	if (a.CompareTo(b) != 0 || la != lb)
+	{
+		return false;
+	}
+
+	return a.ToByteArray(da, la) == b.ToByteArray(db, lb) && memcmp(da, db, la) == 0;
+}
+
+static void Print(const char* name, const BigInteger &value)
+{
+	byte data[MaxBytes];
+	int32 l = value.ToByteArray(data, value.ToByteArraySize());
+
+	printf("  %s = 0x", name);
+
+	for (int32 x = l - 1; x >= 0; --x)
+		printf("%02x", data[x]);
+
+	printf("\n");
+}
+
+static int32 CompareEncodings(Random &rnd)
+{
+	// Encodings with random sign extension bytes, ordered as the decoded values
+
+	byte data[2][MAX_BIGINTEGER_SIZE + 8];
+	int32 length[2];
+
+	for (int32 x = 0; x < 2; ++x)
+	{
+		length[x] = (int32)rnd.Next(MAX_BIGINTEGER_SIZE + 1);
+
+		for (int32 y = 0; y < length[x]; ++y)
+			data[x][y] = (byte)(rnd.Next(3) == 0 ? (rnd.Next(2) == 0 ? 0x00 : 0xFF) : rnd.Next());
+
+		byte extension = length[x] > 0 && (data[x][length[x] - 1] & 0x80) != 0 ? 0xFF : 0x00;
+
+		for (int32 padding = (int32)rnd.Next(8); padding > 0; --padding)
+			data[x][length[x]++] = extension;
+	}
+
+	BigInteger a(data[0], length[0]);
+	BigInteger b(data[1], length[1]);
+
+	int32 expected = a.CompareTo(b);
+	int32 actual = BigInteger::CompareEncoding(data[0], length[0], data[1], length[1]);
+
+	if ((expected > 0) - (expected < 0) == actual)
+	{
+		return 0;
+	}
+
+	printf("CompareEncoding: mismatch, expected %d actual %d\n", expected, actual);
+	Print("a", a);
+	Print("b", b);
+	return 1;
+}
+
+int32 BigIntegerTest(int32 iterations, uint64 seed)
+{
+	Random rnd(seed);
+	Operand a, b;
+	int32 failures = 0;
+
+	for (int32 x = 0; x < iterations && failures < 10; ++x)
+	{
+		a.Randomize(rnd);
+		b.Randomize(rnd);
+
+		if (rnd.Next(8) == 0)
+		{
+			// Close operands, for the cancellations and the quotient corrections
+
+			b = a;
+			b.Negative = rnd.Next(2) == 0;
+
+			if (b.Length > 0)
+				b.Limbs[0] ^= rnd.Next(3);
+
+			b.Update();
+		}
+
+		failures += CompareEncodings(rnd);
+
+		Operation op = (Operation)rnd.Next(5);
+
+		if ((op == Operation::Div || op == Operation::Mod) && b.Length == 0)
+		{
+			BigInteger ret;
+
+			if (Compute(op, a.ToBigInteger(), b.ToBigInteger(), ret))
+			{
+				printf("%s: division by zero not reported\n", OperationNames[(int32)op]);
+				++failures;
+			}
+
+			continue;
+		}
+
+		BigInteger ia = a.ToBigInteger();
+		BigInteger ib = b.ToBigInteger();
+		BigInteger expected = Expected(op, a, b);
+
+		// The destination can be one of the operands
+
+		BigInteger actual, aliased(ia);
+
+		if (!Compute(op, ia, ib, actual) || !Compute(op, aliased, ib, aliased) ||
+			!Equals(actual, expected) || !Equals(aliased, expected))
+		{
+			printf("%s: mismatch at iteration %d (seed %llu)\n", OperationNames[(int32)op], x, (unsigned long long)seed);
+			Print("a", ia);
+			Print("b", ib);
+			Print("expected", expected);
+			Print("actual", actual);
+			Print("aliased", aliased);
+			++failures;
+		}
+	}
+
+	printf("BigInteger: %d iterations, %d failures\n", iterations, failures);
+
+	return failures;
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "Tests.h"
+#include "BigInteger.h"
+#include "ByteKernel.h"
+
+// The vectorized kernels against plain loops and against the BigInteger bitwise operations,
+// the lengths cross the 16 and 32 bytes blocks of SSE2 and AVX2
+
+static const int32 MaxLength = 200;
+
+static void RandomBytes(Random &rnd, byte* data, int32 &length)
+{
+	length = (int32)(rnd.Next(4) == 0 ? rnd.Next(MaxLength + 1) : rnd.Next(MAX_BIGINTEGER_SIZE + 1));
+
+	for (int32 x = 0; x < length; ++x)
+		data[x] = (byte)(rnd.Next(4) == 0 ? (rnd.Next(2) == 0 ? 0x00 : 0xFF) : rnd.Next());
+}
+
+static bool SameValue(const byte* data, int32 length, const BigInteger &expected)
+{
+	BigInteger value((byte*)data, length);
+
+	return value.CompareTo(expected) == 0;
+}
+
+static bool Bitwise(Random &rnd, int32 &checks)
+{
+	byte x[MaxLength], y[MaxLength], z[MaxLength], e[MaxLength];
+	int32 xl, yl;
+
+	RandomBytes(rnd, x, xl);
+	RandomBytes(rnd, y, yl);
+
+	int32 zl = xl > yl ? xl : yl;
+	byte xe = xl > 0 && (x[xl - 1] & 0x80) != 0 ? 0xFF : 0x00;
+	byte ye = yl > 0 && (y[yl - 1] & 0x80) != 0 ? 0xFF : 0x00;
+
+	BigInteger bx(x, xl), by(y, yl), ret;
+
+	for (int32 op = 0; op < 3; ++op)
+	{
+		for (int32 i = 0; i < zl; ++i)
+		{
+			byte a = i < xl ? x[i] : xe;
+			byte b = i < yl ? y[i] : ye;
+
+			e[i] = op == 0 ? (a & b) : (op == 1 ? (a | b) : (a ^ b));
+		}
+
+		switch (op)
+		{
+		case 0: ByteKernel::And(x, xl, y, yl, z); bx.And(by, ret); break;
+		case 1: ByteKernel::Or(x, xl, y, yl, z); bx.Or(by, ret); break;
+		default: ByteKernel::Xor(x, xl, y, yl, z); bx.Xor(by, ret); break;
+		}
+
+		++checks;
+
+		if (memcmp(z, e, zl) != 0 || !SameValue(z, zl, ret))
+		{
+			printf("ByteKernel: %s mismatch, lengths %d and %d\n", op == 0 ? "And" : (op == 1 ? "Or" : "Xor"), xl, yl);
+			return false;
+		}
+	}
+
+	int32 il = xl > 0 ? xl : 1;
+
+	for (int32 i = 0; i < il; ++i)
+		e[i] = i < xl ? (byte)~x[i] : 0xFF;
+
+	ByteKernel::Invert(x, xl, z);
+	bx.Invert(ret);
+
+	++checks;
+
+	if (memcmp(z, e, il) != 0 || !SameValue(z, il, ret))
+	{
+		printf("ByteKernel: Invert mismatch, length %d\n", xl);
+		return false;
+	}
+
+	return true;
+}
+
+static bool Scans(Random &rnd, int32 &checks)
+{
+	byte x[MaxLength], y[MaxLength];
+	int32 length = (int32)rnd.Next(MaxLength + 1);
+
+	for (int32 i = 0; i < length; ++i)
+		x[i] = y[i] = 0;
+
+	// Zero or one different byte, anywhere in the blocks or in the tail
+
+	bool changed = length > 0 && rnd.Next(2) == 0;
+
+	if (changed)
+	{
+		int32 at = (int32)rnd.Next(length);
+		x[at] = (byte)(1 + rnd.Next(0xFF));
+	}
+
+	checks += 2;
+
+	if (ByteKernel::IsZero(x, length) == changed || ByteKernel::Equals(x, y, length) == changed)
+	{
+		printf("ByteKernel: scan mismatch, length %d\n", length);
+		return false;
+	}
+
+	return true;
+}
+
+int32 ByteKernelTest(int32 iterations, uint64 seed)
+{
+	Random rnd(seed);
+	int32 failures = 0, checks = 0;
+
+	for (int32 x = 0; x < iterations && failures < 10; ++x)
+	{
+		if (!Bitwise(rnd, checks)) ++failures;
+		if (!Scans(rnd, checks)) ++failures;
+	}
+
+	printf("ByteKernel (%s): %d checks, %d failures\n", ByteKernel::GetInstructionSet(), checks, failures);
+
+	return failures;
+}
\ No newline at end of file
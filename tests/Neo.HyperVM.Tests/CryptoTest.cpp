@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#include <openssl/ecdsa.h>
+#include <openssl/sha.h>
+
+#include "Tests.h"
+#include "Crypto.h"
+#include "Limits.h"
+#include "SignatureVerifier.h"
+
+// Signatures checked with the cached public keys: every encoding of the key, the keys
+// evicted and decoded again, and several threads sharing the same keys. Then the multisig
+// walk on the workers against the same walk on one thread
+
+class Signer
+{
+public:
+
+	byte Compressed[33];
+	byte Uncompressed[65];
+	byte Signature[64];
+
+	bool Sign(const byte* message, int32 length)
+	{
+		EC_KEY* key = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1);
+
+		if (key == nullptr || EC_KEY_generate_key(key) != 0x01)
+		{
+			if (key != nullptr) EC_KEY_free(key);
+			return false;
+		}
+
+		const EC_GROUP* group = EC_KEY_get0_group(key);
+		const EC_POINT* point = EC_KEY_get0_public_key(key);
+
+		EC_POINT_point2oct(group, point, POINT_CONVERSION_COMPRESSED, this->Compressed, 33, nullptr);
+		EC_POINT_point2oct(group, point, POINT_CONVERSION_UNCOMPRESSED, this->Uncompressed, 65, nullptr);
+
+		byte hash[SHA256_DIGEST_LENGTH];
+		SHA256(message, length, hash);
+
+		ECDSA_SIG* sig = ECDSA_do_sign(hash, SHA256_DIGEST_LENGTH, key);
+		const BIGNUM* r;
+		const BIGNUM* s;
+
+		ECDSA_SIG_get0(sig, &r, &s);
+		memset(this->Signature, 0, 64);
+		BN_bn2bin(r, this->Signature + 32 - BN_num_bytes(r));
+		BN_bn2bin(s, this->Signature + 64 - BN_num_bytes(s));
+
+		ECDSA_SIG_free(sig);
+		EC_KEY_free(key);
+		return true;
+	}
+
+	int32 Check(const byte* message, int32 length, const Signer &other)
+	{
+		// Number of wrong results
+
+		int32 failures = 0;
+
+		if (Crypto::VerifySignature(message, length, this->Signature, 64, this->Compressed, 33) != 1) ++failures;
+		if (Crypto::VerifySignature(message, length, this->Signature, 64, this->Uncompressed, 65) != 1) ++failures;
+		if (Crypto::VerifySignature(message, length, this->Signature, 64, this->Uncompressed + 1, 64) != 1) ++failures;
+		if (Crypto::VerifySignature(message, length, this->Signature, 64, other.Compressed, 33) != 0) ++failures;
+		if (Crypto::VerifySignature(message, length - 1, this->Signature, 64, this->Compressed, 33) != 0) ++failures;
+
+		return failures;
+	}
+};
+
+static int32 Multisig(Random &rnd, const std::vector<Signer> &signers, const byte* hash, int32 &checks)
+{
+	const byte* signatures[16];
+	const byte* pubKeys[16];
+	int32 signaturesL[16], pubKeysL[16];
+
+	int32 pubKeysCount = 1 + (int32)rnd.Next(16);
+	int32 signaturesCount = 1 + (int32)rnd.Next(pubKeysCount);
+
+	// Keys of different signers, the signatures in the same order, sometimes a wrong one
+
+	int32 first = (int32)rnd.Next((uint32)signers.size() - 16);
+	bool valid = true;
+
+	for (int32 j = 0; j < pubKeysCount; ++j)
+	{
+		pubKeys[j] = signers[first + j].Compressed;
+		pubKeysL[j] = 33;
+	}
+
+	for (int32 i = 0, j = 0; i < signaturesCount; ++i)
+	{
+		j += (int32)rnd.Next(pubKeysCount - j - (signaturesCount - i) + 1);
+
+		bool wrong = rnd.Next(8) == 0 && pubKeysCount > 1;
+
+		signatures[i] = signers[wrong ? first + (j + 1) % pubKeysCount : first + j].Signature;
+		signaturesL[i] = 64;
+		valid &= !wrong;
+		++j;
+	}
+
+	int32 failures = 0;
+	bool expected = SignatureVerifier::VerifyMultisig(hash, signatures, signaturesL, signaturesCount, pubKeys, pubKeysL, pubKeysCount, 1);
+
+	++checks;
+
+	if (valid && !expected)
+	{
+		printf("Crypto: multisig %d of %d not verified\n", signaturesCount, pubKeysCount);
+		++failures;
+	}
+
+	for (int32 threads = 2; threads <= MAX_VERIFICATION_THREADS; threads *= 2)
+	{
+		++checks;
+
+		if (SignatureVerifier::VerifyMultisig(hash, signatures, signaturesL, signaturesCount, pubKeys, pubKeysL, pubKeysCount, threads) != expected)
+		{
+			printf("Crypto: multisig mismatch, %d of %d with %d threads\n", signaturesCount, pubKeysCount, threads);
+			++failures;
+		}
+	}
+
+	return failures;
+}
+
+int32 CryptoTest(int32 iterations, uint64 seed)
+{
+	const byte message[] = "neo-hypervm";
+	const int32 length = sizeof(message) - 1;
+
+	// More keys than the cache, so some are evicted and decoded again
+
+	const int32 count = MAX_PUBLIC_KEY_CACHE_SIZE + 64;
+
+	std::vector<Signer> signers(count);
+
+	for (int32 x = 0; x < count; ++x)
+	{
+		if (!signers[x].Sign(message, length))
+		{
+			printf("Crypto: can't sign\n");
+			return 1;
+		}
+	}
+
+	Random rnd(seed);
+	int32 checks = iterations / 100 + count;
+	int32 failures = 0;
+
+	for (int32 x = 0; x < checks; ++x)
+	{
+		int32 i = x < count ? x : (int32)rnd.Next(count);
+
+		failures += signers[i].Check(message, length, signers[(i + 1) % count]);
+	}
+
+	// The same keys from several threads
+
+	const int32 threads = 4;
+	int32 threadFailures[threads] = { };
+	std::vector<std::thread> workers;
+
+	for (int32 t = 0; t < threads; ++t)
+	{
+		workers.push_back(std::thread([&, t]()
+		{
+			for (int32 x = 0; x < checks / threads; ++x)
+			{
+				int32 i = (x * 7 + t) % 16;
+
+				threadFailures[t] += signers[i].Check(message, length, signers[i + 1]);
+			}
+		}));
+	}
+
+	for (auto &worker : workers)
+		worker.join();
+
+	for (int32 t = 0; t < threads; ++t)
+		failures += threadFailures[t];
+
+	// Multisig walks, some of them from several engine threads at the same time
+
+	byte hash[SHA256_DIGEST_LENGTH];
+	SHA256(message, length, hash);
+
+	int32 multisigChecks = 0;
+
+	for (int32 x = 0; x < iterations / 1000 + 16; ++x)
+		failures += Multisig(rnd, signers, hash, multisigChecks);
+
+	workers.clear();
+
+	for (int32 t = 0; t < threads; ++t)
+	{
+		threadFailures[t] = 0;
+
+		workers.push_back(std::thread([&, t]()
+		{
+			Random trnd(seed + t + 1);
+			int32 tchecks = 0;
+
+			for (int32 x = 0; x < 16; ++x)
+				threadFailures[t] += Multisig(trnd, signers, hash, tchecks);
+		}));
+	}
+
+	for (auto &worker : workers)
+		worker.join();
+
+	for (int32 t = 0; t < threads; ++t)
+		failures += threadFailures[t];
+
+	printf("Crypto: %d checks, %d multisig checks, %d failures\n", 2 * checks, multisigChecks, failures);
+
+	return failures;
+}
\ No newline at end of file
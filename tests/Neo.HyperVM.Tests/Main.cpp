@@ -0,0 +1,20 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Tests.h"
+
+// usage: Neo.HyperVM.Tests [iterations] [seed]
+
+int main(int argc, char* argv[])
+{
+	int32 iterations = argc > 1 ? atoi(argv[1]) : 200000;
+	uint64 seed = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1;
+
+	int32 failures = 0;
+
+	failures += BigIntegerTest(iterations, seed);
+	failures += ByteKernelTest(iterations, seed);
+	failures += CryptoTest(iterations, seed);
+
+	return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
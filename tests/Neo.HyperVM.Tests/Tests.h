@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Types.h"
+
+// Native tests, each one returns the number of failures
+
+int32 BigIntegerTest(int32 iterations, uint64 seed);
+int32 ByteKernelTest(int32 iterations, uint64 seed);
+int32 CryptoTest(int32 iterations, uint64 seed);
+
+// Deterministic generator, so a failure can be reproduced from its seed
+
+class Random
+{
+private:
+
+	uint64 _state;
+
+public:
+
+	inline Random(uint64 seed) : _state(seed == 0 ? 0x9E3779B97F4A7C15ULL : seed) { }
+
+	inline uint64 Next()
+	{
+		// xorshift64*
+
+		this->_state ^= this->_state >> 12;
+		this->_state ^= this->_state << 25;
+		this->_state ^= this->_state >> 27;
+		return this->_state * 0x2545F4914F6CDD1DULL;
+	}
+
+	inline uint32 Next(uint32 max)
+	{
+		return (uint32)(this->Next() % max);
+	}
+};
\ No newline at end of file
@@ -1144,6 +1144,359 @@ namespace NeoSharp.VM.Interop.Tests
             }
         }
 
+        [TestMethod]
+        public void PACKED_ITEMS()
+        {
+            // Booleans and small integers are stored packed in the arrays
+
+            using (var script = new ScriptBuilder
+            (
+                EVMOpCode.PUSH0,
+                EVMOpCode.NOT,
+                EVMOpCode.PUSH5,
+                EVMOpCode.PUSH2,
+                EVMOpCode.PACK,
+
+                // PICKITEM keeps the type
+
+                EVMOpCode.DUP,
+                EVMOpCode.PUSH0,
+                EVMOpCode.PICKITEM,
+                EVMOpCode.OVER,
+                EVMOpCode.PUSH1,
+                EVMOpCode.PICKITEM,
+
+                EVMOpCode.RET
+            ))
+            using (var engine = CreateEngine(Args))
+            {
+                engine.LoadScript(script);
+
+                Assert.IsTrue(engine.Execute());
+
+                using (var i = engine.ResultStack.Pop<BooleanStackItem>())
+                {
+                    Assert.IsTrue(i.Value);
+                }
+
+                using (var i = engine.ResultStack.Pop<IntegerStackItem>())
+                {
+                    Assert.AreEqual(5, i.Value);
+                }
+
+                CheckArrayPop(engine.ResultStack, false, 0x05, true);
+                CheckClean(engine);
+            }
+
+            // SETITEM and APPEND
+
+            using (var script = new ScriptBuilder
+            (
+                EVMOpCode.PUSH3,
+                EVMOpCode.PUSH2,
+                EVMOpCode.PUSH1,
+                EVMOpCode.PUSH3,
+                EVMOpCode.PACK,
+
+                EVMOpCode.DUP,
+                EVMOpCode.PUSH1,
+                EVMOpCode.PUSH9,
+                EVMOpCode.SETITEM,
+                EVMOpCode.DUP,
+                EVMOpCode.PUSH2,
+                EVMOpCode.PUSH0,
+                EVMOpCode.NOT,
+                EVMOpCode.SETITEM,
+
+                EVMOpCode.DUP,
+                EVMOpCode.PUSH7,
+                EVMOpCode.APPEND,
+                EVMOpCode.DUP,
+                EVMOpCode.PUSH0,
+                EVMOpCode.APPEND,
+
+                EVMOpCode.RET
+            ))
+            using (var engine = CreateEngine(Args))
+            {
+                engine.LoadScript(script);
+
+                Assert.IsTrue(engine.Execute());
+
+                CheckArrayPop(engine.ResultStack, false, 0x01, 0x09, true, 0x07, 0x00);
+                CheckClean(engine);
+            }
+
+            // REVERSE with packed and regular items
+
+            using (var script = new ScriptBuilder())
+            using (var engine = CreateEngine(Args))
+            {
+                script.EmitPush(3);
+                script.EmitPush(new byte[] { 0x61, 0x62 });
+                script.EmitPush(1);
+                script.Emit(EVMOpCode.PUSH3, EVMOpCode.PACK, EVMOpCode.DUP, EVMOpCode.REVERSE, EVMOpCode.RET);
+
+                engine.LoadScript(script);
+
+                Assert.IsTrue(engine.Execute());
+
+                using (var arr = engine.ResultStack.Pop<ArrayStackItem>())
+                {
+                    Assert.AreEqual(3, arr.Count);
+
+                    using (IntegerStackItem a = (IntegerStackItem)arr[0], c = (IntegerStackItem)arr[2])
+                    using (var b = (ByteArrayStackItem)arr[1])
+                    {
+                        Assert.AreEqual(3, a.Value);
+                        CollectionAssert.AreEqual(new byte[] { 0x61, 0x62 }, b.Value);
+                        Assert.AreEqual(1, c.Value);
+                    }
+                }
+
+                CheckClean(engine);
+            }
+
+            // A packed item is boxed in the array on the first read, the next reads don't allocate it again
+
+            ulong memory;
+
+            using (var script = new ScriptBuilder
+            (
+                EVMOpCode.PUSH3, EVMOpCode.PUSH2, EVMOpCode.PUSH1, EVMOpCode.PUSH3, EVMOpCode.PACK,
+                EVMOpCode.DUP, EVMOpCode.PUSH1, EVMOpCode.PICKITEM, EVMOpCode.DROP
+            ))
+            using (var engine = (Types.ExecutionEngine)CreateEngine(Args))
+            {
+                engine.LoadScript(script);
+
+                Assert.IsTrue(engine.Execute());
+
+                memory = engine.MemoryUsage;
+            }
+
+            using (var script = new ScriptBuilder
+            (
+                EVMOpCode.PUSH3, EVMOpCode.PUSH2, EVMOpCode.PUSH1, EVMOpCode.PUSH3, EVMOpCode.PACK,
+                EVMOpCode.DUP, EVMOpCode.PUSH1, EVMOpCode.PICKITEM, EVMOpCode.DROP,
+                EVMOpCode.DUP, EVMOpCode.PUSH1, EVMOpCode.PICKITEM, EVMOpCode.DROP
+            ))
+            using (var engine = (Types.ExecutionEngine)CreateEngine(Args))
+            {
+                engine.LoadScript(script);
+
+                Assert.IsTrue(engine.Execute());
+                Assert.AreEqual(memory, engine.MemoryUsage);
+
+                CheckArrayPop(engine.ResultStack, false, 0x01, 0x02, 0x03);
+                CheckClean(engine);
+            }
+        }
+
+        [TestMethod]
+        public void PACKED_ITEMS_STACK_LIMIT()
+        {
+            // The packed items read by UNPACK and PICKITEM take the place of their slots, they aren't counted again
+
+            for (int extra = 1022; extra <= 1023; extra++)
+            {
+                using (var script = new ScriptBuilder())
+                using (var engine = CreateEngine(Args))
+                {
+                    script.EmitPush(1024);
+                    script.Emit(EVMOpCode.NEWARRAY, EVMOpCode.DUP, EVMOpCode.UNPACK);
+
+                    // The array, its 1024 items and the count, up to the 2048 items of the stack limit
+
+                    for (int x = 0; x < extra; x++)
+                    {
+                        script.Emit(EVMOpCode.PUSH1);
+                    }
+
+                    engine.LoadScript(script);
+
+                    if (extra == 1022)
+                    {
+                        Assert.IsTrue(engine.Execute());
+                        Assert.AreEqual(2048, engine.ResultStack.Count);
+                    }
+                    else
+                    {
+                        Assert.IsFalse(engine.Execute());
+                        Assert.AreEqual(EVMState.Fault, engine.State);
+                    }
+                }
+            }
+
+            using (var script = new ScriptBuilder())
+            using (var engine = CreateEngine(Args))
+            {
+                script.EmitPush(1000);
+                script.Emit(EVMOpCode.NEWARRAY);
+
+                for (int x = 0; x < 1500; x++)
+                {
+                    script.Emit(EVMOpCode.DUP, EVMOpCode.PUSH0, EVMOpCode.PICKITEM, EVMOpCode.SWAP);
+                }
+
+                engine.LoadScript(script);
+
+                Assert.IsTrue(engine.Execute());
+                Assert.AreEqual(1501, engine.ResultStack.Count);
+            }
+        }
+
+        [TestMethod]
+        public void COPY_ON_WRITE()
+        {
+            // DUP shares the struct, the change is seen by both
+
+            using (var script = new ScriptBuilder())
+            using (var engine = CreateEngine(Args))
+            {
+                EmitStruct123(script);
+                script.Emit(EVMOpCode.DUP);
+                EmitChanges(script);
+                script.Emit(EVMOpCode.RET);
+
+                engine.LoadScript(script);
+
+                Assert.IsTrue(engine.Execute());
+
+                CheckArrayPop(engine.ResultStack, true, 0x09, 0x03, 0x04);
+                CheckArrayPop(engine.ResultStack, true, 0x09, 0x03, 0x04);
+
+                CheckClean(engine);
+            }
+
+            // PICKITEM returns a copy, change the original (reached by UNPACK)
+
+            using (var script = new ScriptBuilder())
+            using (var engine = CreateEngine(Args))
+            {
+                script.Emit(EVMOpCode.PUSH0, EVMOpCode.NEWARRAY, EVMOpCode.TOALTSTACK);
+                EmitStruct123(script);
+                script.Emit
+                    (
+                    EVMOpCode.DUPFROMALTSTACK, EVMOpCode.SWAP, EVMOpCode.APPEND,
+                    EVMOpCode.DUPFROMALTSTACK, EVMOpCode.PUSH0, EVMOpCode.PICKITEM,
+                    EVMOpCode.FROMALTSTACK, EVMOpCode.UNPACK, EVMOpCode.DROP
+                    );
+                EmitChanges(script);
+                script.Emit(EVMOpCode.RET);
+
+                engine.LoadScript(script);
+
+                Assert.IsTrue(engine.Execute());
+
+                CheckArrayPop(engine.ResultStack, true, 0x09, 0x03, 0x04);
+                CheckArrayPop(engine.ResultStack, true, 0x01, 0x02, 0x03);
+
+                CheckClean(engine);
+            }
+
+            // APPEND stores a clone, change the original
+
+            using (var script = new ScriptBuilder())
+            using (var engine = CreateEngine(Args))
+            {
+                script.Emit(EVMOpCode.PUSH0, EVMOpCode.NEWARRAY, EVMOpCode.TOALTSTACK);
+                EmitStruct123(script);
+                script.Emit(EVMOpCode.DUP, EVMOpCode.DUPFROMALTSTACK, EVMOpCode.SWAP, EVMOpCode.APPEND);
+                EmitChanges(script);
+                script.Emit(EVMOpCode.FROMALTSTACK, EVMOpCode.PUSH0, EVMOpCode.PICKITEM, EVMOpCode.RET);
+
+                engine.LoadScript(script);
+
+                Assert.IsTrue(engine.Execute());
+
+                CheckArrayPop(engine.ResultStack, true, 0x01, 0x02, 0x03);
+                CheckArrayPop(engine.ResultStack, true, 0x09, 0x03, 0x04);
+
+                CheckClean(engine);
+            }
+
+            // SETITEM stores a clone, change the original
+
+            using (var script = new ScriptBuilder())
+            using (var engine = CreateEngine(Args))
+            {
+                script.Emit(EVMOpCode.PUSH1, EVMOpCode.NEWARRAY, EVMOpCode.TOALTSTACK);
+                EmitStruct123(script);
+                script.Emit(EVMOpCode.DUPFROMALTSTACK, EVMOpCode.PUSH0, EVMOpCode.PUSH2, EVMOpCode.PICK, EVMOpCode.SETITEM);
+                EmitChanges(script);
+                script.Emit(EVMOpCode.FROMALTSTACK, EVMOpCode.PUSH0, EVMOpCode.PICKITEM, EVMOpCode.RET);
+
+                engine.LoadScript(script);
+
+                Assert.IsTrue(engine.Execute());
+
+                CheckArrayPop(engine.ResultStack, true, 0x01, 0x02, 0x03);
+                CheckArrayPop(engine.ResultStack, true, 0x09, 0x03, 0x04);
+
+                CheckClean(engine);
+            }
+
+            // VALUES returns a copy of the array, change the original
+
+            using (var script = new ScriptBuilder
+                (
+                EVMOpCode.PUSH3,
+                EVMOpCode.PUSH2,
+                EVMOpCode.PUSH1,
+                EVMOpCode.PUSH3,
+                EVMOpCode.PACK,
+                EVMOpCode.DUP,
+                EVMOpCode.VALUES,
+                EVMOpCode.SWAP
+                ))
+            using (var engine = CreateEngine(Args))
+            {
+                EmitChanges(script);
+                script.Emit(EVMOpCode.RET);
+
+                engine.LoadScript(script);
+
+                Assert.IsTrue(engine.Execute());
+
+                CheckArrayPop(engine.ResultStack, false, 0x09, 0x03, 0x04);
+                CheckArrayPop(engine.ResultStack, false, 0x01, 0x02, 0x03);
+
+                CheckClean(engine);
+            }
+        }
+
+        /// <summary>
+        /// Push the struct [1,2,3]
+        /// </summary>
+        /// <param name="script">Script</param>
+        private static void EmitStruct123(ScriptBuilder script)
+        {
+            script.Emit(EVMOpCode.PUSH3, EVMOpCode.NEWSTRUCT);
+
+            for (int x = 0; x < 3; x++)
+            {
+                script.Emit(EVMOpCode.DUP);
+                script.EmitPush(x);
+                script.EmitPush(x + 1);
+                script.Emit(EVMOpCode.SETITEM);
+            }
+        }
+
+        /// <summary>
+        /// Turn the array on the top of the stack into [9,3,4] with SETITEM, APPEND and REMOVE, the array stays on the stack
+        /// </summary>
+        /// <param name="script">Script</param>
+        private static void EmitChanges(ScriptBuilder script)
+        {
+            script.Emit
+                (
+                EVMOpCode.DUP, EVMOpCode.PUSH0, EVMOpCode.PUSH9, EVMOpCode.SETITEM,
+                EVMOpCode.DUP, EVMOpCode.PUSH4, EVMOpCode.APPEND,
+                EVMOpCode.DUP, EVMOpCode.PUSH1, EVMOpCode.REMOVE
+                );
+        }
+
         [TestMethod]
         public void HASKEY()
         {
@@ -1338,6 +1691,95 @@ namespace NeoSharp.VM.Interop.Tests
             }
         }
 
+        [TestMethod]
+        public void KEYS_VALUES_Order()
+        {
+            // Insertion order after SETITEM, REMOVE and re-insert, then after removing most of the entries
+
+            using (var script = new ScriptBuilder
+            (
+                EVMOpCode.NEWMAP,
+                EVMOpCode.TOALTSTACK,
+
+                // m[1]=11, m[2]=12, m[3]=13, m[4]=14
+
+                EVMOpCode.DUPFROMALTSTACK,
+                EVMOpCode.PUSH1,
+                EVMOpCode.PUSH11,
+                EVMOpCode.SETITEM,
+                EVMOpCode.DUPFROMALTSTACK,
+                EVMOpCode.PUSH2,
+                EVMOpCode.PUSH12,
+                EVMOpCode.SETITEM,
+                EVMOpCode.DUPFROMALTSTACK,
+                EVMOpCode.PUSH3,
+                EVMOpCode.PUSH13,
+                EVMOpCode.SETITEM,
+                EVMOpCode.DUPFROMALTSTACK,
+                EVMOpCode.PUSH4,
+                EVMOpCode.PUSH14,
+                EVMOpCode.SETITEM,
+
+                // Remove m[2], update m[1]=16 (same position), then m[2]=15 (at the end)
+
+                EVMOpCode.DUPFROMALTSTACK,
+                EVMOpCode.PUSH2,
+                EVMOpCode.REMOVE,
+                EVMOpCode.DUPFROMALTSTACK,
+                EVMOpCode.PUSH1,
+                EVMOpCode.PUSH16,
+                EVMOpCode.SETITEM,
+                EVMOpCode.DUPFROMALTSTACK,
+                EVMOpCode.PUSH2,
+                EVMOpCode.PUSH15,
+                EVMOpCode.SETITEM,
+
+                EVMOpCode.DUPFROMALTSTACK,
+                EVMOpCode.KEYS,
+                EVMOpCode.DUPFROMALTSTACK,
+                EVMOpCode.VALUES,
+
+                // Remove m[1] and m[3], then m[5]=10
+
+                EVMOpCode.DUPFROMALTSTACK,
+                EVMOpCode.PUSH1,
+                EVMOpCode.REMOVE,
+                EVMOpCode.DUPFROMALTSTACK,
+                EVMOpCode.PUSH3,
+                EVMOpCode.REMOVE,
+                EVMOpCode.DUPFROMALTSTACK,
+                EVMOpCode.PUSH5,
+                EVMOpCode.PUSH10,
+                EVMOpCode.SETITEM,
+
+                EVMOpCode.DUPFROMALTSTACK,
+                EVMOpCode.KEYS,
+                EVMOpCode.FROMALTSTACK,
+                EVMOpCode.VALUES,
+
+                EVMOpCode.RET
+            ))
+            using (var engine = CreateEngine(Args))
+            {
+                // Load script
+
+                engine.LoadScript(script);
+
+                // Execute
+
+                Assert.IsTrue(engine.Execute());
+
+                // Check
+
+                CheckArrayPop(engine.ResultStack, false, 14, 15, 10);
+                CheckArrayPop(engine.ResultStack, false, 4, 2, 5);
+                CheckArrayPop(engine.ResultStack, false, 16, 13, 14, 15);
+                CheckArrayPop(engine.ResultStack, false, 1, 3, 4, 2);
+
+                CheckClean(engine);
+            }
+        }
+
         [TestMethod]
         public void VALUES()
         {
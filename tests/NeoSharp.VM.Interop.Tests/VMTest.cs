@@ -1,7 +1,8 @@
-using System;
+﻿using System;
 using System.Collections.Generic;
 using System.Linq;
 using System.Numerics;
+using System.Runtime.CompilerServices;
 using System.Security.Cryptography;
 using System.Text;
 using System.Threading.Tasks;
@@ -122,6 +123,408 @@ namespace NeoSharp.VM.Interop.Tests
             }
         }
 
+        [TestMethod]
+        public void TestEngineReuse()
+        {
+            StackItemBase item;
+
+            using (var script = new ScriptBuilder(EVMOpCode.PUSH5, EVMOpCode.NEWARRAY, EVMOpCode.PUSH1))
+            {
+                using (var engine = CreateEngine(Args))
+                {
+                    engine.LoadScript(script);
+
+                    Assert.IsTrue(engine.Execute());
+                    Assert.AreEqual(2, engine.ResultStack.Count);
+
+                    item = engine.ResultStack.Peek(1);
+                }
+
+                // The next engine of this thread reuses the native one, it must be pristine
+
+                using (var engine = CreateEngine(Args))
+                {
+                    Assert.AreEqual(EVMState.None, engine.State);
+                    Assert.AreEqual(0UL, engine.ConsumedGas);
+                    Assert.AreEqual(0, engine.InvocationStack.Count);
+                    Assert.AreEqual(0, engine.ResultStack.Count);
+
+                    Assert.AreEqual(0, engine.LoadScript(script));
+                    Assert.IsTrue(engine.Execute());
+                    Assert.AreEqual(2, engine.ResultStack.Count);
+                }
+            }
+
+            // Items of the previous execution are still alive
+
+            Assert.IsTrue(item is ArrayStackItem arr && arr.Count == 5);
+            item.Dispose();
+        }
+
+        [TestMethod]
+        public void TestEnginePoolClear()
+        {
+            using (var script = new ScriptBuilder(EVMOpCode.PUSH1))
+            {
+                for (int x = 0; x < 2; x++)
+                {
+                    using (var engine = CreateEngine(Args))
+                    {
+                        engine.LoadScript(script);
+                        Assert.IsTrue(engine.Execute());
+                    }
+
+                    // Free the pooled engine, the next one is created again
+
+                    NeoVM.ClearEnginePool();
+                    NeoVM.ClearEnginePool();
+                }
+            }
+        }
+
+        [TestMethod]
+        public void TestClaimedContext()
+        {
+            using (var script = new ScriptBuilder(new byte[]
+            {
+                /* ┌─◄ */ (byte)EVMOpCode.CALL,
+                /* │   */ 0x07, 0x00,
+                /* │┌◄ */ (byte)EVMOpCode.CALL,
+                /* ││  */ 0x06, 0x00,
+                /* ││  */ (byte)EVMOpCode.RET,
+                /* └►  */ (byte)EVMOpCode.PUSH1,
+                /*  │  */ (byte)EVMOpCode.RET,
+                /*  └► */ (byte)EVMOpCode.PUSH2,
+                /*     */ (byte)EVMOpCode.RET,
+            }))
+            using (var engine = CreateEngine(Args))
+            {
+                engine.LoadScript(script);
+                engine.StepInto();
+
+                var first = (Types.ExecutionContext)engine.CurrentContext;
+                Assert.AreEqual(7, first.InstructionPointer);
+
+                // The first call returns, the second one can't reuse the context held here
+
+                engine.StepInto(4);
+
+                var second = (Types.ExecutionContext)engine.CurrentContext;
+
+                Assert.AreNotEqual(first.Handle, second.Handle);
+                Assert.AreEqual(10, second.InstructionPointer);
+                Assert.AreEqual(9, first.InstructionPointer);
+
+                Assert.IsTrue(engine.Execute());
+                Assert.AreEqual(2, engine.ResultStack.Count);
+            }
+        }
+
+        [TestMethod]
+        public void TestClaimedContextLogs()
+        {
+            var handles = new HashSet<IntPtr>();
+
+            using (var script = new ScriptBuilder(new byte[]
+            {
+                /* ┌─◄ */ (byte)EVMOpCode.CALL,
+                /* │   */ 0x04, 0x00,
+                /* │   */ (byte)EVMOpCode.RET,
+                /* └►  */ (byte)EVMOpCode.PUSH1,
+                /*     */ (byte)EVMOpCode.RET,
+            }))
+            using (var engine = CreateEngine(new ExecutionEngineArgs()
+            {
+                Logger = new ExecutionEngineLogger(ELogVerbosity.StepInto)
+            }))
+            {
+                engine.Logger.OnStepInto += (context) =>
+                {
+                    handles.Add(((Types.ExecutionContext)context).Handle);
+                };
+
+                // The contexts of the log are released after each step, so the engine keeps reusing them
+
+                for (uint x = 0; x < 100; x++)
+                {
+                    engine.Clean(x);
+                    engine.LoadScript(script);
+
+                    Assert.IsTrue(engine.Execute());
+                    Assert.AreEqual(1, engine.ResultStack.Count);
+                }
+
+                Assert.AreEqual(2, handles.Count);
+
+                // A context held by the host is released by its finalizer, and reused after the next Clean
+
+                engine.Clean(100);
+                engine.LoadScript(script);
+                engine.StepInto();
+
+                ReadCurrentContext(engine);
+
+                Assert.IsTrue(engine.Execute());
+
+                GC.Collect();
+                GC.WaitForPendingFinalizers();
+
+                for (uint x = 101; x < 200; x++)
+                {
+                    engine.Clean(x);
+                    engine.LoadScript(script);
+
+                    Assert.IsTrue(engine.Execute());
+                }
+
+                Assert.AreEqual(2, handles.Count);
+            }
+        }
+
+        /// <summary>
+        /// Read the current context through a wrapper that is not kept
+        /// </summary>
+        /// <param name="engine">Engine</param>
+        [MethodImpl(MethodImplOptions.NoInlining)]
+        private static void ReadCurrentContext(ExecutionEngineBase engine)
+        {
+            Assert.AreEqual(4, engine.CurrentContext.InstructionPointer);
+        }
+
+        [TestMethod]
+        public void TestCycles()
+        {
+            var scripts = new EVMOpCode[][]
+            {
+                // a.Add(a)
+
+                new EVMOpCode[]
+                {
+                    EVMOpCode.PUSH0, EVMOpCode.NEWARRAY,
+                    EVMOpCode.DUP, EVMOpCode.DUP, EVMOpCode.APPEND,
+                    EVMOpCode.DROP
+                },
+
+                // a.Add(b), b.Add(a)
+
+                new EVMOpCode[]
+                {
+                    EVMOpCode.PUSH0, EVMOpCode.NEWARRAY, EVMOpCode.PUSH0, EVMOpCode.NEWARRAY,
+                    EVMOpCode.OVER, EVMOpCode.OVER, EVMOpCode.APPEND,
+                    EVMOpCode.OVER, EVMOpCode.OVER, EVMOpCode.SWAP, EVMOpCode.APPEND,
+                    EVMOpCode.DROP, EVMOpCode.DROP
+                },
+
+                // s.Add(a), a.Add(s), the struct is cloned with a reference to the array
+
+                new EVMOpCode[]
+                {
+                    EVMOpCode.PUSH0, EVMOpCode.NEWSTRUCT, EVMOpCode.PUSH0, EVMOpCode.NEWARRAY,
+                    EVMOpCode.OVER, EVMOpCode.OVER, EVMOpCode.APPEND,
+                    EVMOpCode.SWAP, EVMOpCode.APPEND
+                },
+
+                // m[1] = m
+
+                new EVMOpCode[]
+                {
+                    EVMOpCode.NEWMAP,
+                    EVMOpCode.DUP, EVMOpCode.PUSH1, EVMOpCode.OVER, EVMOpCode.SETITEM,
+                    EVMOpCode.DROP
+                },
+
+                // m1[1] = m2, m2[1] = m1
+
+                new EVMOpCode[]
+                {
+                    EVMOpCode.NEWMAP, EVMOpCode.NEWMAP,
+                    EVMOpCode.OVER, EVMOpCode.PUSH1, EVMOpCode.PUSH2, EVMOpCode.PICK, EVMOpCode.SETITEM,
+                    EVMOpCode.DUP, EVMOpCode.PUSH1, EVMOpCode.PUSH3, EVMOpCode.PICK, EVMOpCode.SETITEM,
+                    EVMOpCode.DROP, EVMOpCode.DROP
+                },
+            };
+
+            foreach (var ops in scripts)
+            {
+                using (var script = new ScriptBuilder(ops))
+                using (var engine = (Types.ExecutionEngine)CreateEngine(Args))
+                {
+                    engine.LoadScript(script);
+
+                    // The unreachable cycles are freed when the entry context returns
+
+                    Assert.IsTrue(engine.Execute());
+                    Assert.AreEqual(EVMState.Halt, engine.State);
+
+                    Assert.IsTrue(engine.PeakMemoryUsage > 0);
+                    Assert.AreEqual(0UL, engine.MemoryUsage);
+
+                    CheckClean(engine);
+                }
+            }
+
+            // A cycle held by the host is freed after the host releases it
+
+            using (var script = new ScriptBuilder(EVMOpCode.PUSH0, EVMOpCode.NEWARRAY, EVMOpCode.DUP, EVMOpCode.DUP, EVMOpCode.APPEND))
+            using (var engine = (Types.ExecutionEngine)CreateEngine(Args))
+            {
+                engine.LoadScript(script);
+
+                Assert.IsTrue(engine.Execute());
+                Assert.AreNotEqual(0UL, engine.MemoryUsage);
+
+                using (var arr = engine.ResultStack.Pop<ArrayStackItem>())
+                {
+                    Assert.AreEqual(1, arr.Count);
+                }
+
+                engine.Clean();
+
+                Assert.AreEqual(0UL, engine.MemoryUsage);
+            }
+        }
+
+        [TestMethod]
+        public void TestMemoryLimit()
+        {
+            using (var script = new ScriptBuilder())
+            {
+                script.EmitPush(new byte[2000]);
+                script.Emit(EVMOpCode.DROP);
+
+                using (var engine = (Types.ExecutionEngine)CreateEngine(Args))
+                {
+                    engine.SetMemoryLimit(1024);
+                    engine.LoadScript(script);
+
+                    Assert.IsFalse(engine.Execute());
+                    Assert.AreEqual(Types.ExecutionEngine.FaultByMemory, engine.State);
+                }
+
+                // The same script fits with a bigger limit
+
+                using (var engine = (Types.ExecutionEngine)CreateEngine(Args))
+                {
+                    engine.SetMemoryLimit(4096);
+                    engine.LoadScript(script);
+
+                    Assert.IsTrue(engine.Execute());
+                    Assert.AreEqual(EVMState.Halt, engine.State);
+
+                    CheckClean(engine);
+                }
+            }
+        }
+
+        [TestMethod]
+        public void TestMemoryUsage()
+        {
+            using (var script = new ScriptBuilder())
+            using (var engine = (Types.ExecutionEngine)CreateEngine(Args))
+            {
+                script.EmitPush(new byte[100]);
+                script.Emit(EVMOpCode.DROP);
+
+                engine.LoadScript(script);
+
+                Assert.AreEqual(0UL, engine.MemoryUsage);
+
+                // Push
+
+                engine.StepInto();
+
+                var usage = engine.MemoryUsage;
+
+                Assert.IsTrue(usage >= 100);
+                Assert.AreEqual(usage, engine.PeakMemoryUsage);
+
+                // Drop, the peak stays
+
+                engine.StepInto();
+
+                Assert.AreEqual(0UL, engine.MemoryUsage);
+                Assert.AreEqual(usage, engine.PeakMemoryUsage);
+
+                Assert.IsTrue(engine.Execute());
+                Assert.AreEqual(usage, engine.PeakMemoryUsage);
+
+                CheckClean(engine);
+            }
+        }
+
+        [TestMethod]
+        public void TestFork()
+        {
+            using (var script = new ScriptBuilder(EVMOpCode.PUSH1, EVMOpCode.PUSH2, EVMOpCode.ADD))
+            using (var engine = (Types.ExecutionEngine)CreateEngine(Args))
+            {
+                engine.LoadScript(script);
+                engine.StepInto(2);
+
+                using (var fork = engine.Fork())
+                {
+                    Assert.AreEqual(engine.State, fork.State);
+                    Assert.AreEqual(engine.ConsumedGas, fork.ConsumedGas);
+                    Assert.AreEqual(2, fork.CurrentContext.EvaluationStack.Count);
+
+                    // Each engine runs the rest of the script with its own stack
+
+                    Assert.IsTrue(fork.Execute());
+                    Assert.AreEqual(2, engine.CurrentContext.EvaluationStack.Count);
+                    Assert.IsTrue(engine.Execute());
+
+                    Assert.AreEqual(engine.ConsumedGas, fork.ConsumedGas);
+
+                    using (IntegerStackItem a = engine.ResultStack.Pop<IntegerStackItem>(), b = fork.ResultStack.Pop<IntegerStackItem>())
+                    {
+                        Assert.AreEqual(a.Value, 3);
+                        Assert.AreEqual(b.Value, 3);
+                    }
+                }
+            }
+        }
+
+        [TestMethod]
+        public void TestForkInterop()
+        {
+            var dummy = new DisposableDummy();
+
+            using (var script = new ScriptBuilder(EVMOpCode.NOP))
+            {
+                Types.ExecutionEngine fork;
+
+                using (var engine = (Types.ExecutionEngine)CreateEngine(Args))
+                {
+                    engine.LoadScript(script);
+                    engine.StepInto();
+
+                    using (var it = engine.CreateInterop(dummy))
+                    {
+                        engine.CurrentContext.EvaluationStack.Push(it);
+                    }
+
+                    fork = engine.Fork();
+                }
+
+                // The fork still holds the object of the disposed parent
+
+                using (fork)
+                {
+                    Assert.IsFalse(dummy.IsDisposed);
+                    Assert.IsTrue(fork.Execute());
+
+                    using (var it = fork.ResultStack.Pop<InteropStackItem<DisposableDummy>>())
+                    {
+                        Assert.AreEqual(dummy, it.Value);
+                    }
+
+                    Assert.IsFalse(dummy.IsDisposed);
+                }
+
+                Assert.IsTrue(dummy.IsDisposed);
+            }
+        }
+
         [TestMethod]
         public void TestParallel()
         {